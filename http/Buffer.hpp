@@ -0,0 +1,126 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define EXTRA_BUFFER_SIZE 65536 // 读套接字时栈上临时缓冲区的大小
+
+// 连接的输入缓冲区：一次从套接字读取一大块数据，再交给解析器在内存中解析、按长度取出
+// [0, reader_idx) 已被取走，[reader_idx, writer_idx) 是可读数据，[writer_idx, size) 是空闲空间
+class Buffer
+{
+private:
+    std::vector<char> buffer;
+    size_t reader_idx;
+    size_t writer_idx;
+
+private:
+    char *Begin()
+    {
+        return buffer.data();
+    }
+
+    size_t WritableSize()
+    {
+        return buffer.size() - writer_idx;
+    }
+
+    // 保证尾部至少有 len 字节的空闲空间：前面已取走的空间够用就把数据挪到开头，否则扩容
+    void EnsureWritable(size_t len)
+    {
+        if (WritableSize() >= len)
+        {
+            return;
+        }
+        size_t readable = ReadableSize();
+        if (reader_idx + WritableSize() >= len)
+        {
+            memmove(Begin(), Begin() + reader_idx, readable);
+        }
+        else
+        {
+            std::vector<char> bigger(readable + len);
+            memcpy(bigger.data(), Begin() + reader_idx, readable);
+            buffer.swap(bigger);
+        }
+        reader_idx = 0;
+        writer_idx = readable;
+    }
+
+    void Append(const char *data, size_t len)
+    {
+        EnsureWritable(len);
+        memcpy(Begin() + writer_idx, data, len);
+        writer_idx += len;
+    }
+
+public:
+    // 初始不分配空间，空闲连接不占内存；第一次读取时按实际数据量分配
+    Buffer() : reader_idx(0), writer_idx(0)
+    {
+    }
+
+    const char *Peek()
+    {
+        return buffer.data() + reader_idx;
+    }
+
+    size_t ReadableSize()
+    {
+        return writer_idx - reader_idx;
+    }
+
+    // 取走 len 字节
+    void Retrieve(size_t len)
+    {
+        if (len < ReadableSize())
+        {
+            reader_idx += len;
+        }
+        else
+        {
+            reader_idx = writer_idx = 0; // 全部取走，下次从头开始写
+        }
+    }
+
+    // 从套接字读取一批数据：缓冲区空闲空间不够时，多出的部分先读到栈上，再追加进来
+    // 这样一次系统调用就能读到尽可能多的数据，又不需要预先给每个连接分配大块内存
+    // 返回值同 readv
+    ssize_t ReadFd(int fd)
+    {
+        char extrabuf[EXTRA_BUFFER_SIZE];
+        size_t writable = WritableSize();
+        struct iovec vec[2];
+        vec[0].iov_base = Begin() + writer_idx;
+        vec[0].iov_len = writable;
+        vec[1].iov_base = extrabuf;
+        vec[1].iov_len = sizeof(extrabuf);
+        ssize_t n = readv(fd, vec, 2);
+        if (n > 0)
+        {
+            if ((size_t)n <= writable)
+            {
+                writer_idx += n;
+            }
+            else
+            {
+                writer_idx = buffer.size();
+                Append(extrabuf, n - writable);
+            }
+        }
+        return n;
+    }
+
+    // 最多取出 len 字节追加到 out，返回实际取出的字节数
+    size_t GetBytes(std::string &out, size_t len)
+    {
+        size_t n = std::min(len, ReadableSize());
+        out.append(Peek(), n);
+        Retrieve(n);
+        return n;
+    }
+};
@@ -0,0 +1,459 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include "logs/mylog.h"
+#include "Utill.hpp"
+#include "Poller.hpp"
+#include "Spawn.hpp"
+#include "Stats.hpp"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+// 注册到 Poller 的 ptr：CgiProcess 的地址加上下面的标记（地址是对齐的，低 2 位为 0），
+// reactor 据此区分是连接的事件还是 CGI 子进程的哪一个描述符
+#define CGI_STDIN 1     // 子进程的标准输入：写请求正文
+#define CGI_STDOUT 2    // 子进程的标准输出：读响应正文
+#define CGI_EXIT 3      // 子进程的 pidfd：退出
+#define CGI_TAG_MASK 3
+#define CGI_READ_SIZE 65536 // 每次从管道读取的字节数
+#define CGI_PIPE_SIZE (1 << 20)        // 流式发送时标准输出管道的容量，每次 splice 能移动更多数据
+#define CGI_POOL_BUFFERS 8             // 每个线程缓存的输出缓冲区个数
+#define CGI_POOL_MAX_SIZE (4 << 20)    // 容量超过这个大小的缓冲区用完直接释放，不缓存
+
+#define CGI_OUTPUT_BUFFER 0 // CGI 输出的发送方式：读完整个输出，按 Content-Length 发送（可以保持连接）
+#define CGI_OUTPUT_SPLICE 1 // CGI 输出的发送方式：子进程启动后就发送响应头，正文用 splice 从管道直接发送，以关闭连接表示结束
+#define CGI_OUTPUT_STREAM 2 // CGI 输出的发送方式：子进程第一次输出时发送响应头，正文边读边发（HTTP/1.1 分块编码，HTTP/1.0 以关闭连接表示结束）
+
+// reactor 处理 CGI 描述符的事件之后要做的事
+enum CgiEvent
+{
+    CGI_EVENT_NONE,   // 继续等待
+    CGI_EVENT_OUTPUT, // 流式发送：标准输出有数据了，继续发送输出队列
+    CGI_EVENT_EXITED  // 子进程的描述符都关闭了，执行结束
+};
+
+enum CgiState
+{
+    CGI_IDLE,    // 没有在执行
+    CGI_RUNNING, // 子进程在执行，由 reactor 驱动
+    CGI_DONE     // 结束了，结果在 Code() 和 TakeOutput() 中
+};
+
+// 按线程缓存用过的 CGI 输出缓冲区，下一个 CGI 请求直接复用，不用重新分配内存、重新缺页
+// 读输出（reactor 线程的 OnStdout）和发送完归还（同一个 reactor 的 SendChunks）在同一个线程，不用加锁
+class CgiBufferPool
+{
+private:
+    static std::vector<std::string> &Free()
+    {
+        static thread_local std::vector<std::string> free;
+        return free;
+    }
+
+public:
+    // 取一个空的缓冲区放到 out 中（没有缓存的时候 out 不变）
+    static void Get(std::string &out)
+    {
+        auto &free = Free();
+        if (!free.empty())
+        {
+            out.swap(free.back());
+            free.pop_back();
+        }
+        out.clear();
+    }
+
+    // 归还已经发送完的缓冲区，太小（响应头）或太大的不缓存
+    static void Put(std::string &buf)
+    {
+        if (buf.capacity() < CGI_READ_SIZE || buf.capacity() > CGI_POOL_MAX_SIZE)
+        {
+            return;
+        }
+        auto &free = Free();
+        if (free.size() < CGI_POOL_BUFFERS)
+        {
+            free.push_back(std::move(buf));
+        }
+    }
+
+    // 从 fd 读一块数据追加到 out 后面，返回值和 read 相同
+    static ssize_t ReadAppend(int fd, std::string &out)
+    {
+        if (out.capacity() == 0)
+        {
+            Get(out);
+        }
+        size_t have = out.size();
+        out.resize(have + CGI_READ_SIZE);
+        ssize_t s = read(fd, &out[have], CGI_READ_SIZE);
+        out.resize(have + (s > 0 ? s : 0));
+        return s;
+    }
+};
+
+// 由事件循环驱动的 CGI 子进程：管道是非阻塞的，和子进程的 pidfd 一起注册到连接所在的 reactor，
+// 写请求正文、读输出、收集退出状态都在就绪时进行，执行期间不占用任何线程
+// 工作线程调用 Start 之后就不再碰这个对象和它所属的连接；三个描述符都关闭之后 OnEvent 返回 CGI_EVENT_EXITED，
+// 由 reactor 把连接交回线程池构建响应
+// 流式发送（CGI_OUTPUT_SPLICE、CGI_OUTPUT_STREAM）时标准输出不由这里读取：由连接的输出队列直接发送到套接字，
+// 管道空了才通过 WatchStdout 等待；CGI_OUTPUT_STREAM 在启动时就注册标准输出，第一次可读时通知 reactor 发送响应头
+class alignas(8) CgiProcess
+{
+private:
+    void *owner;    // 所属的 EndPoint
+    Poller *poller; // 所属连接的 reactor 的 I/O 后端
+    CgiState state;
+    pid_t pid;
+    int fds[4];                // 按 CGI_STDIN/CGI_STDOUT/CGI_EXIT 下标，-1 表示已关闭
+    int open;                  // 还没有关闭的描述符个数
+    bool stream;               // 标准输出由连接的输出队列直接发送
+    bool stdout_added;         // 流式发送时标准输出是否已经注册到 reactor
+    bool stdout_armed;         // 标准输出正在等待事件（事件送达之前不能关闭，见 Abandon）
+    bool abandoned;            // 连接已经关闭，子进程已被杀掉，剩下的描述符收到事件就关闭
+    uint64_t start_ms;         // 子进程启动的时间（单调时钟的毫秒数），CGI 执行超时从这里开始计算
+    const std::string *body;   // 请求正文（属于 EndPoint，执行期间不会变化）
+    size_t written;            // 已经写给子进程的字节数
+    std::string output;        // 子进程的输出
+    int code;                  // 状态码（按退出状态）
+
+    CgiProcess(const CgiProcess &) = delete;
+
+    void *Tag(int kind)
+    {
+        return (void *)((uintptr_t)this | kind);
+    }
+
+    void Close(int kind)
+    {
+        poller->Del(fds[kind], Tag(kind), false);
+        close(fds[kind]);
+        fds[kind] = -1;
+        if (--open == 0)
+        {
+            state = CGI_DONE;
+            ServerStats::getinstance()->cgi_running--;
+        }
+    }
+
+    void OnStdin()
+    {
+        while (written < body->size())
+        {
+            ssize_t s = write(fds[CGI_STDIN], body->data() + written, body->size() - written);
+            if (s > 0)
+            {
+                written += s;
+                continue;
+            }
+            if (s < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (s < 0 && Utill::WouldBlock())
+            {
+                poller->Mod(fds[CGI_STDIN], EPOLLOUT, Tag(CGI_STDIN));
+                return;
+            }
+            break; // 子进程不再读取（EPIPE）
+        }
+        Close(CGI_STDIN); // 正文写完，关闭后子进程读到文件结束
+    }
+
+    void OnStdout()
+    {
+        while (true)
+        {
+            ssize_t s = CgiBufferPool::ReadAppend(fds[CGI_STDOUT], output);
+            if (s > 0 || (s < 0 && errno == EINTR))
+            {
+                continue;
+            }
+            if (s < 0 && Utill::WouldBlock())
+            {
+                stdout_armed = true;
+                poller->Mod(fds[CGI_STDOUT], EPOLLIN, Tag(CGI_STDOUT));
+                return;
+            }
+            Close(CGI_STDOUT); // 子进程关闭了标准输出
+            return;
+        }
+    }
+
+    void OnExit()
+    {
+        siginfo_t info;
+        info.si_pid = 0;
+        if (waitid((idtype_t)P_PIDFD, fds[CGI_EXIT], &info, WEXITED | WNOHANG) < 0 && errno == EINTR)
+        {
+            poller->Mod(fds[CGI_EXIT], EPOLLIN, Tag(CGI_EXIT));
+            return;
+        }
+        if (info.si_pid == 0)
+        {
+            poller->Mod(fds[CGI_EXIT], EPOLLIN, Tag(CGI_EXIT)); // 还没有退出
+            return;
+        }
+        if (info.si_code == CLD_EXITED)
+        {
+            code = info.si_status == 0 ? 200 : 400; // 和 ProcessCgi 相同：OK / BAD_REQUEST
+        }
+        else
+        {
+            code = 500; // 被信号终止：SERVER_ERROR
+        }
+        Close(CGI_EXIT);
+    }
+
+public:
+    CgiProcess(void *_owner, Poller *_poller)
+        : owner(_owner), poller(_poller), state(CGI_IDLE), pid(-1), fds{-1, -1, -1, -1}, open(0), stream(false), stdout_added(false),
+          stdout_armed(false), abandoned(false), start_ms(0), body(nullptr), written(0), code(0)
+    {
+    }
+
+    // 内核是否支持 pidfd（5.3），不支持时 CGI 请求仍然由 CGI 线程池的线程阻塞等待
+    static bool Supported()
+    {
+        static bool ok = [] {
+            int fd = (int)syscall(SYS_pidfd_open, getpid(), 0);
+            if (fd < 0)
+            {
+                return false;
+            }
+            close(fd);
+            return true;
+        }();
+        return ok;
+    }
+
+    static bool IsTagged(void *ptr)
+    {
+        return ((uintptr_t)ptr & CGI_TAG_MASK) != 0;
+    }
+
+    static CgiProcess *FromEvent(void *ptr, int &kind)
+    {
+        kind = (int)((uintptr_t)ptr & CGI_TAG_MASK);
+        return (CgiProcess *)((uintptr_t)ptr & ~(uintptr_t)CGI_TAG_MASK);
+    }
+
+    void *Owner()
+    {
+        return owner;
+    }
+
+    CgiState State()
+    {
+        return state;
+    }
+
+    bool Streaming()
+    {
+        return stream;
+    }
+
+    // 流式发送时由输出队列发送的标准输出管道
+    int StdoutFd()
+    {
+        return fds[CGI_STDOUT];
+    }
+
+    uint64_t StartMs()
+    {
+        return start_ms;
+    }
+
+    int Code()
+    {
+        return code;
+    }
+
+    void TakeOutput(std::string &out)
+    {
+        out.swap(output);
+        output.clear();
+    }
+
+    // 启动子进程并注册到 reactor（mode 是输出的发送方式，CGI_OUTPUT_*），成功返回 true，之后调用者不能再访问这个对象和所属的连接
+    // （流式发送时还可以取 StdoutFd，把管道交给输出队列）
+    // 启动失败返回 false，状态为 CGI_DONE，Code() 是要回复的状态码
+    bool Start(const std::string &path, const std::vector<std::string> &env, const std::string &_body, int mode)
+    {
+        state = CGI_DONE;
+        code = 404; // 和 ProcessCgi 相同：程序启动失败回复 NOT_FOUND
+        int input[2], out[2]; // 子进程的标准输入、标准输出
+        if (pipe2(input, O_CLOEXEC) < 0)
+        {
+            ERROR("%s", "pipe input error");
+            code = 500;
+            return false;
+        }
+        if (pipe2(out, O_CLOEXEC) < 0)
+        {
+            ERROR("%s", "pipe output error");
+            close(input[0]);
+            close(input[1]);
+            code = 500;
+            return false;
+        }
+        pid = Spawn::Run(path.c_str(), env, input[0], out[1]);
+        close(input[0]);
+        close(out[1]);
+        int pidfd = pid < 0 ? -1 : (int)syscall(SYS_pidfd_open, pid, 0);
+        if (pidfd < 0)
+        {
+            ERROR("spawn %s error: %s", path.c_str(), strerror(errno));
+            if (pid > 0)
+            {
+                kill(pid, SIGKILL);
+                waitpid(pid, nullptr, 0);
+            }
+            close(input[1]);
+            close(out[0]);
+            return false;
+        }
+        // 只有父进程这一端是非阻塞的，子进程的标准输入输出仍然是阻塞的
+        Utill::SetNonBlock(input[1]);
+        Utill::SetNonBlock(out[0]);
+        if (mode != CGI_OUTPUT_BUFFER)
+        {
+            fcntl(out[0], F_SETPIPE_SZ, CGI_PIPE_SIZE); // 失败（超过 pipe-max-size）时保持默认大小
+        }
+
+        body = &_body;
+        written = 0;
+        output.clear();
+        fds[CGI_STDIN] = input[1];
+        fds[CGI_STDOUT] = out[0];
+        fds[CGI_EXIT] = pidfd;
+        open = 3;
+        stream = mode != CGI_OUTPUT_BUFFER;
+        stdout_added = mode != CGI_OUTPUT_SPLICE;
+        stdout_armed = stdout_added;
+        abandoned = false;
+        start_ms = Utill::NowUs() / 1000;
+        state = CGI_RUNNING;
+        ServerStats::getinstance()->cgi_running++;
+        ServerStats::getinstance()->cgi_processes++;
+
+        // 标准输入最后注册：pidfd 先注册，标准输出还没有注册之前即使子进程已经退出也不会结束；
+        // 注册完最后一个之后 reactor 随时可能结束这个子进程并把连接交给别的线程
+        // 没有正文时也注册（立即可写，reactor 随即关闭它），保证 reactor 在子进程启动后马上收到一个事件，开始计算执行超时
+        int stdin_fd = fds[CGI_STDIN];
+        bool watch_stdout = stdout_added;
+        poller->Add(pidfd, EPOLLIN, Tag(CGI_EXIT));
+        if (watch_stdout)
+        {
+            poller->Add(out[0], EPOLLIN, Tag(CGI_STDOUT));
+        }
+        poller->Add(stdin_fd, EPOLLOUT, Tag(CGI_STDIN));
+        return true;
+    }
+
+    // reactor 收到 kind 对应描述符的事件
+    CgiEvent OnEvent(int kind)
+    {
+        if (kind == CGI_STDOUT)
+        {
+            stdout_armed = false;
+        }
+        if (abandoned && kind != CGI_EXIT)
+        {
+            Close(kind); // 取消的事件送达了，输出已经没人要了
+            return open == 0 ? CGI_EVENT_EXITED : CGI_EVENT_NONE;
+        }
+        switch (kind)
+        {
+        case CGI_STDIN:
+            OnStdin();
+            break;
+        case CGI_STDOUT:
+            if (stream)
+            {
+                return CGI_EVENT_OUTPUT;
+            }
+            OnStdout();
+            break;
+        case CGI_EXIT:
+            OnExit();
+            break;
+        }
+        return open == 0 ? CGI_EVENT_EXITED : CGI_EVENT_NONE;
+    }
+
+    // 流式发送：管道暂时没有数据，等子进程的输出（reactor 线程调用）
+    void WatchStdout()
+    {
+        if (stdout_added)
+        {
+            stdout_armed = true;
+            poller->Mod(fds[CGI_STDOUT], EPOLLIN, Tag(CGI_STDOUT));
+            return;
+        }
+        stdout_added = true;
+        stdout_armed = true;
+        poller->Add(fds[CGI_STDOUT], EPOLLIN, Tag(CGI_STDOUT));
+    }
+
+    // 流式发送：标准输出已经发送到文件结束
+    void CloseStdout()
+    {
+        Close(CGI_STDOUT);
+    }
+
+    // 连接在子进程执行期间关闭了（流式发送时对端断开、超时或 CGI 执行超时）：输出已经没人要了，杀掉子进程所在的进程组；
+    // 返回 true 表示子进程的描述符还没有都关闭，要等 CGI_EVENT_EXITED 之后才能释放连接
+    // 正在等待事件的描述符不能直接关闭（事件可能已经在这一批里，或者 io_uring 的 poll 还引用着它）：
+    // 整个进程组被杀掉之后管道的另一端都关闭了，pidfd 也会就绪，事件送达时再关闭；
+    // 离开了进程组（setsid）还拿着管道的进程结束之前连接不会释放
+    bool Abandon()
+    {
+        if (state != CGI_RUNNING)
+        {
+            return false;
+        }
+        abandoned = true;
+        kill(-pid, SIGKILL); // 组长还没有被回收（或者组里还有进程）时进程组号不会被重用
+        if (fds[CGI_STDOUT] >= 0 && !stdout_armed)
+        {
+            Close(CGI_STDOUT); // 流式发送时标准输出由输出队列发送，没有在等待事件
+        }
+        return state == CGI_RUNNING;
+    }
+
+    // 长连接处理下一个请求之前
+    void Reset()
+    {
+        state = CGI_IDLE;
+        stream = false;
+        abandoned = false;
+        output.clear();
+        body = nullptr;
+        code = 0;
+    }
+
+    ~CgiProcess()
+    {
+        for (int fd : fds)
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+    }
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#define QUEUE_TARGET_MS 20    // 任务在队列中的目标等待时间（毫秒），0 表示不做队列管理
+#define QUEUE_INTERVAL_MS 100 // 观察窗口（毫秒）
+
+// CoDel 风格的队列管理，在出队时判断任务是否应该直接拒绝
+// 每个观察窗口记录任务在队列中等待的最短时间：如果整个窗口里连等得最短的任务都超过了目标，
+// 说明队列里形成了一直消化不掉的积压（而不是短暂的突发），下一个窗口里等待超过 2 倍目标的任务直接回复 503，
+// 让队列尽快排空，后面的请求不用再陪着排队；突发的请求只要有一个等待时间低于目标就不会被拒绝
+// 多个线程可以同时调用：窗口切换由 CAS 抢到的一个线程完成，其余状态的竞争只影响统计的精度
+class Codel
+{
+private:
+    std::atomic<uint64_t> target;       // 目标等待时间（微秒）
+    std::atomic<uint64_t> interval;     // 观察窗口（微秒）
+    std::atomic<uint64_t> interval_end; // 当前窗口的结束时间
+    std::atomic<uint64_t> min_delay;    // 当前窗口中最短的等待时间
+    std::atomic<bool> overloaded;       // 上一个窗口是否过载
+
+public:
+    Codel(int target_ms = QUEUE_TARGET_MS, int interval_ms = QUEUE_INTERVAL_MS)
+        : interval_end(0), min_delay(UINT64_MAX), overloaded(false)
+    {
+        SetTarget(target_ms, interval_ms);
+    }
+
+    void SetTarget(int target_ms, int interval_ms)
+    {
+        target.store((uint64_t)target_ms * 1000, std::memory_order_relaxed);
+        interval.store((uint64_t)interval_ms * 1000, std::memory_order_relaxed);
+    }
+
+    bool Overloaded()
+    {
+        return overloaded;
+    }
+
+    // delay：任务在队列中等待的时间；now：当前时间（微秒）；返回 true 表示应该拒绝这个任务
+    bool ShouldDrop(uint64_t delay, uint64_t now)
+    {
+        uint64_t _target = target.load(std::memory_order_relaxed);
+        if (_target == 0)
+        {
+            return false;
+        }
+        uint64_t end = interval_end.load(std::memory_order_relaxed);
+        if (now >= end && interval_end.compare_exchange_strong(end, now + interval.load(std::memory_order_relaxed)))
+        {
+            overloaded.store(end != 0 && min_delay.load(std::memory_order_relaxed) > _target, std::memory_order_relaxed);
+            min_delay.store(delay, std::memory_order_relaxed);
+        }
+        else
+        {
+            uint64_t cur = min_delay.load(std::memory_order_relaxed);
+            while (delay < cur && !min_delay.compare_exchange_weak(cur, delay, std::memory_order_relaxed))
+            {
+            }
+        }
+        return overloaded.load(std::memory_order_relaxed) && delay > 2 * _target;
+    }
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Poller.hpp"
+#include "Codel.hpp"
+#include "Placement.hpp"
+#include "CgiProcess.hpp"
+#include <string>
+#include <vector>
+
+#define POOL_GLOBAL 0 // 线程池：所有线程共享一个任务队列
+#define POOL_STEAL 1  // 线程池：每个线程有自己的任务队列，空闲的线程从别的线程那里偷任务
+
+#define PORT 8081
+#define KEEPALIVE_TIMEOUT 15      // 长连接空闲超时（秒），0 表示不使用长连接
+#define MAX_KEEPALIVE_REQUESTS 100 // 一个长连接最多处理的请求数
+#define REQUEST_LINE_TIMEOUT 10   // 接收请求行的超时（秒），从连接建立或上一个请求开始时计时
+#define HEADER_TIMEOUT 10         // 接收请求报头的超时（秒）
+#define BODY_TIMEOUT 30           // 接收请求正文的超时（秒）
+#define SEND_TIMEOUT 30           // 发送响应时两次可写之间的超时（秒）
+#define CGI_TIMEOUT 60            // CGI 子进程的执行超时（秒），从启动开始计时，到期时杀掉子进程并关闭连接
+#define MAX_CONNECTIONS 20000     // 整个服务器最多同时打开的连接数，超过时直接回复 503 并关闭
+#define MAX_QUEUED_REQUESTS 1024  // 线程池任务队列最多积压的请求数（向上取整到 2 的幂），超过时直接回复 503
+
+// 服务器的可配置参数，默认值如上，可以通过命令行修改
+struct ServerConfig
+{
+    int reactor_num;       // 事件循环个数，0 表示每个 CPU 一个
+    int keepalive_timeout; // 长连接空闲超时（秒）
+    int max_requests;      // 每个连接最多处理的请求数
+    int backend;           // I/O 后端：BACKEND_EPOLL 或 BACKEND_URING
+    // 各阶段的超时（秒），0 表示不限制；接收请求的各阶段从进入该阶段开始计时，收到数据不会延长
+    int request_line_timeout;
+    int header_timeout;
+    int body_timeout;
+    int send_timeout;
+    int cgi_timeout;
+    // 过载保护
+    int max_connections; // 0 表示不限制
+    // 静态线程池（reactor 先把所有请求交给它）和 CGI 线程池分别设置
+    int max_queued;      // 0 表示使用 TASK_QUEUE_CAPACITY
+    int cgi_max_queued;
+    int queue_target;   // 任务队列的目标等待时间（毫秒），0 表示不做队列管理（见 Codel）
+    int cgi_queue_target;
+    int queue_interval; // 队列管理的观察窗口（毫秒）
+    int pool_mode;      // 线程池的调度方式：POOL_GLOBAL 或 POOL_STEAL
+    int min_threads;    // 线程池的线程数下限，0 表示 CPU 个数
+    int max_threads;    // 线程池的线程数上限，0 表示 CPU 个数的 THREADS_PER_CPU 倍
+    int cgi_min_threads;
+    int cgi_max_threads;
+    int affinity;         // 线程的放置：AFFINITY_NONE、AFFINITY_CORES 或 AFFINITY_IRQ
+    std::string irq_name; // AFFINITY_IRQ 下网卡接收队列的中断名（/proc/interrupts 中的子串）
+    std::vector<std::string> fastcgi; // FastCGI 路由，每条 "路径前缀或 *.后缀=地址"（见 FastCgi）
+    int fastcgi_conns;                // 每个 FastCGI 后端最多的连接数，0 表示 FCGI_MAX_CONNS
+    int cgi_output;                   // CGI 输出的发送方式：CGI_OUTPUT_BUFFER、CGI_OUTPUT_SPLICE 或 CGI_OUTPUT_STREAM
+    bool status_page;                 // 是否开放 STATUS_URI：计数器暴露了服务器的内部状态，默认关闭
+
+    ServerConfig()
+        : reactor_num(1),
+          keepalive_timeout(KEEPALIVE_TIMEOUT),
+          max_requests(MAX_KEEPALIVE_REQUESTS),
+          backend(BACKEND_EPOLL),
+          request_line_timeout(REQUEST_LINE_TIMEOUT),
+          header_timeout(HEADER_TIMEOUT),
+          body_timeout(BODY_TIMEOUT),
+          send_timeout(SEND_TIMEOUT),
+          cgi_timeout(CGI_TIMEOUT),
+          max_connections(MAX_CONNECTIONS),
+          max_queued(MAX_QUEUED_REQUESTS),
+          cgi_max_queued(MAX_QUEUED_REQUESTS),
+          queue_target(QUEUE_TARGET_MS),
+          cgi_queue_target(QUEUE_TARGET_MS),
+          queue_interval(QUEUE_INTERVAL_MS),
+          pool_mode(POOL_GLOBAL),
+          min_threads(0),
+          max_threads(0),
+          cgi_min_threads(0),
+          cgi_max_threads(0),
+          affinity(AFFINITY_NONE),
+          fastcgi_conns(0),
+          cgi_output(CGI_OUTPUT_BUFFER),
+          status_page(false)
+    {
+    }
+};
@@ -0,0 +1,707 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "logs/mylog.h"
+#include "Buffer.hpp"
+#include "Stats.hpp"
+
+// FastCGI 协议（版本 1）的记录类型和常量
+#define FCGI_VERSION_1 1
+#define FCGI_BEGIN_REQUEST 1
+#define FCGI_END_REQUEST 3
+#define FCGI_PARAMS 4
+#define FCGI_STDIN 5
+#define FCGI_STDOUT 6
+#define FCGI_STDERR 7
+#define FCGI_GET_VALUES 9
+#define FCGI_GET_VALUES_RESULT 10
+#define FCGI_RESPONDER 1
+#define FCGI_KEEP_CONN 1
+#define FCGI_CANT_MPX_CONN 1
+#define FCGI_HEADER_LEN 8
+#define FCGI_MAX_RECORD 65535 // 一条记录最多的内容字节数
+
+#define FCGI_MAX_CONNS 8          // 默认每个后端最多的连接数
+#define FCGI_MAX_STREAMS 16       // 后端支持多路复用时一个连接上同时进行的请求数上限
+#define FCGI_PROBE_TIMEOUT_MS 500 // 新连接上询问后端能否多路复用（FCGI_GET_VALUES）时等待回答的时间
+#define FCGI_IO_TIMEOUT 30        // 读写后端的超时（秒），超时的连接连同上面所有的请求一起作废
+
+// FastCGI::Request 的结果
+#define FCGI_OK 0          // 后端处理完了请求（应用的退出码在 app_status 中）
+#define FCGI_UNAVAILABLE 1 // 连不上后端，请求没有发出去
+#define FCGI_FAILED 2      // 请求发出去了，但是连接出错或超时
+
+// 一个请求的参数（名字-值对），直接按 FastCGI 的编码追加，不保存中间结果
+class FastCgiParams
+{
+private:
+    std::string data;
+
+    void AppendLength(size_t n)
+    {
+        if (n < 128)
+        {
+            data.push_back((char)n);
+            return;
+        }
+        data.push_back((char)(((n >> 24) & 0x7f) | 0x80));
+        data.push_back((char)(n >> 16));
+        data.push_back((char)(n >> 8));
+        data.push_back((char)n);
+    }
+
+public:
+    void Add(std::string_view name, std::string_view value)
+    {
+        AppendLength(name.size());
+        AppendLength(value.size());
+        data.append(name.data(), name.size());
+        data.append(value.data(), value.size());
+    }
+
+    const std::string &Data() const
+    {
+        return data;
+    }
+};
+
+// 一个请求的输出，由读取连接的线程填写
+struct FastCgiResult
+{
+    std::string out; // FCGI_STDOUT：CGI 格式的响应（报头 + 空行 + 正文）
+    std::string err; // FCGI_STDERR
+    uint32_t app_status;
+    uint8_t protocol_status;
+    bool done;   // 收到了 FCGI_END_REQUEST，或者连接出错
+    bool failed; // 连接出错
+
+    FastCgiResult() : app_status(0), protocol_status(0), done(false), failed(false) {}
+
+    void Reset()
+    {
+        out.clear();
+        err.clear();
+        app_status = 0;
+        protocol_status = 0;
+        done = false;
+        failed = false;
+    }
+};
+
+// 到 FastCGI 后端的一个长连接，可以同时进行 streams 个请求（请求 id 区分）
+// 写入时加 write_lock，一次写完一个请求的全部记录；
+// 读取由等待结果的线程轮流负责（leader/follower）：同一时间只有一个线程读套接字，
+// 读到别的请求的记录就放进它们的结果里并唤醒它们，自己的请求结束后把读取交给下一个还在等的线程
+struct FastCgiConn
+{
+    int fd;
+    int streams;    // 最多同时进行的请求数（后端不支持多路复用时为 1），由 FastCgiBackend 的锁保护
+    int active;     // 正在进行的请求数，由 FastCgiBackend 的锁保护
+    int served;     // 已经完成的请求数（大于 0 说明是复用的连接），由 FastCgiBackend 的锁保护
+    bool broken;    // 连接出错，不再使用，最后一个请求结束时关闭
+    bool reading;   // 有线程正在读这个连接
+    uint16_t next_id;
+    std::map<uint16_t, FastCgiResult *> pending; // 进行中的请求
+    Buffer inbuf;                                // 只由正在读的线程访问
+    pthread_mutex_t lock;                        // 保护 broken、reading、pending 和结果
+    pthread_cond_t cond;
+    pthread_mutex_t write_lock;
+
+    FastCgiConn(int _fd, int _streams)
+        : fd(_fd), streams(_streams), active(0), served(0), broken(false), reading(false), next_id(0)
+    {
+        pthread_mutex_init(&lock, nullptr);
+        pthread_cond_init(&cond, nullptr);
+        pthread_mutex_init(&write_lock, nullptr);
+    }
+
+    ~FastCgiConn()
+    {
+        close(fd);
+        pthread_mutex_destroy(&lock);
+        pthread_cond_destroy(&cond);
+        pthread_mutex_destroy(&write_lock);
+    }
+};
+
+// 一个 FastCGI 后端（Unix 套接字或 TCP 地址）和到它的连接池
+// 请求在 CGI 线程池中执行，线程阻塞在后端的套接字上，收完整个 FCGI_STDOUT 才返回（见 EndPoint::ProcessFastCgi）
+class FastCgiBackend
+{
+private:
+    std::string address;
+    struct sockaddr_storage addr;
+    socklen_t addrlen;
+    int max_conns;
+    std::vector<std::shared_ptr<FastCgiConn>> conns;
+    int connecting; // 正在建立的连接数，和 conns 一起不超过 max_conns
+    pthread_mutex_t lock;
+    pthread_cond_t cond; // 连接上有了空闲的位置
+
+    FastCgiBackend(const FastCgiBackend &) = delete;
+
+    // 追加一条记录，内容补齐到 8 字节
+    static void AppendRecord(std::string &out, uint8_t type, uint16_t id, const char *data, size_t len)
+    {
+        uint8_t padding = (8 - len % 8) % 8;
+        char header[FCGI_HEADER_LEN] = {FCGI_VERSION_1, (char)type, (char)(id >> 8), (char)id,
+                                         (char)(len >> 8), (char)len, (char)padding, 0};
+        out.append(header, FCGI_HEADER_LEN);
+        if (len > 0)
+        {
+            out.append(data, len);
+        }
+        out.append(padding, '\0');
+    }
+
+    // 追加一个流（FCGI_PARAMS、FCGI_STDIN）：按记录的最大长度切开，最后一条空记录表示结束
+    static void AppendStream(std::string &out, uint8_t type, uint16_t id, const std::string &data)
+    {
+        for (size_t off = 0; off < data.size(); off += FCGI_MAX_RECORD)
+        {
+            AppendRecord(out, type, id, data.data() + off, std::min(data.size() - off, (size_t)FCGI_MAX_RECORD));
+        }
+        AppendRecord(out, type, id, nullptr, 0);
+    }
+
+    static bool WriteAll(int fd, const std::string &data)
+    {
+        size_t done = 0;
+        while (done < data.size())
+        {
+            ssize_t s = send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+            if (s > 0)
+            {
+                done += s;
+            }
+            else if (s < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // 解析 "unix:/path"、"/path" 或 "host:port"
+    bool ParseAddress()
+    {
+        memset(&addr, 0, sizeof(addr));
+        std::string path;
+        if (address.compare(0, 5, "unix:") == 0)
+        {
+            path = address.substr(5);
+        }
+        else if (!address.empty() && address[0] == '/')
+        {
+            path = address;
+        }
+        if (!path.empty())
+        {
+            struct sockaddr_un *un = (struct sockaddr_un *)&addr;
+            if (path.size() >= sizeof(un->sun_path))
+            {
+                return false;
+            }
+            un->sun_family = AF_UNIX;
+            memcpy(un->sun_path, path.c_str(), path.size() + 1);
+            addrlen = sizeof(*un);
+            return true;
+        }
+        size_t colon = address.rfind(':');
+        if (colon == std::string::npos)
+        {
+            return false;
+        }
+        struct addrinfo hints, *res = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_socktype = SOCK_STREAM;
+        if (getaddrinfo(address.substr(0, colon).c_str(), address.substr(colon + 1).c_str(), &hints, &res) != 0 || res == nullptr)
+        {
+            return false;
+        }
+        memcpy(&addr, res->ai_addr, res->ai_addrlen);
+        addrlen = res->ai_addrlen;
+        freeaddrinfo(res);
+        return true;
+    }
+
+    int Connect()
+    {
+        int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&addr, addrlen) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+        struct timeval tv = {FCGI_IO_TIMEOUT, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (addr.ss_family != AF_UNIX)
+        {
+            int opt = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+        return fd;
+    }
+
+    // 读一个名字-值对的长度
+    static bool ReadLength(const uint8_t *&p, const uint8_t *end, size_t &n)
+    {
+        if (p >= end)
+        {
+            return false;
+        }
+        if (*p < 128)
+        {
+            n = *p++;
+            return true;
+        }
+        if (end - p < 4)
+        {
+            return false;
+        }
+        n = ((size_t)(p[0] & 0x7f) << 24) | ((size_t)p[1] << 16) | ((size_t)p[2] << 8) | p[3];
+        p += 4;
+        return true;
+    }
+
+    // 新连接上询问后端能否多路复用、最多同时处理多少个请求，返回这个连接上同时进行的请求数
+    // 有的后端不回答 FCGI_GET_VALUES，等不到回答就每个连接一个请求；迟到的回答由读取线程忽略
+    int Probe(int fd)
+    {
+        FastCgiParams query;
+        query.Add("FCGI_MPXS_CONNS", "");
+        query.Add("FCGI_MAX_REQS", "");
+        std::string out;
+        AppendRecord(out, FCGI_GET_VALUES, 0, query.Data().data(), query.Data().size());
+        if (!WriteAll(fd, out))
+        {
+            return 1;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        uint8_t header[FCGI_HEADER_LEN];
+        if (poll(&pfd, 1, FCGI_PROBE_TIMEOUT_MS) <= 0 || recv(fd, header, FCGI_HEADER_LEN, MSG_WAITALL) != FCGI_HEADER_LEN)
+        {
+            return 1;
+        }
+        // 整条记录都读走，不认识 FCGI_GET_VALUES 的后端回答的 FCGI_UNKNOWN_TYPE 也不会留在连接上
+        size_t len = ((size_t)header[4] << 8) | header[5];
+        std::vector<uint8_t> content(len + header[6]);
+        if ((!content.empty() && recv(fd, content.data(), content.size(), MSG_WAITALL) != (ssize_t)content.size()) ||
+            header[1] != FCGI_GET_VALUES_RESULT)
+        {
+            return 1;
+        }
+        bool mpxs = false;
+        int max_reqs = FCGI_MAX_STREAMS;
+        const uint8_t *p = content.data(), *end = content.data() + len;
+        size_t nlen, vlen;
+        while (ReadLength(p, end, nlen) && ReadLength(p, end, vlen) && (size_t)(end - p) >= nlen + vlen)
+        {
+            std::string name((const char *)p, nlen), value((const char *)p + nlen, vlen);
+            p += nlen + vlen;
+            if (name == "FCGI_MPXS_CONNS")
+            {
+                mpxs = atoi(value.c_str()) > 0;
+            }
+            else if (name == "FCGI_MAX_REQS" && atoi(value.c_str()) > 0)
+            {
+                max_reqs = std::min(max_reqs, atoi(value.c_str()));
+            }
+        }
+        return mpxs ? max_reqs : 1;
+    }
+
+    // 取一个还有空位的连接（请求最少的），没有就新建，连接数到了上限就等
+    // 连不上后端返回 nullptr
+    std::shared_ptr<FastCgiConn> Acquire()
+    {
+        pthread_mutex_lock(&lock);
+        while (true)
+        {
+            std::shared_ptr<FastCgiConn> best;
+            for (auto &conn : conns)
+            {
+                if (!conn->broken && conn->active < conn->streams && (!best || conn->active < best->active))
+                {
+                    best = conn;
+                }
+            }
+            if (best)
+            {
+                best->active++;
+                pthread_mutex_unlock(&lock);
+                return best;
+            }
+            if ((int)conns.size() + connecting < max_conns)
+            {
+                connecting++;
+                pthread_mutex_unlock(&lock);
+                int fd = Connect();
+                int err = errno;
+                int streams = fd >= 0 ? Probe(fd) : 0;
+                pthread_mutex_lock(&lock);
+                connecting--;
+                if (fd < 0)
+                {
+                    pthread_cond_broadcast(&cond);
+                    pthread_mutex_unlock(&lock);
+                    WARN("fastcgi %s: connect failed: %s", address.c_str(), strerror(err));
+                    return nullptr;
+                }
+                auto conn = std::make_shared<FastCgiConn>(fd, streams);
+                conn->active = 1;
+                conns.push_back(conn);
+                ServerStats::getinstance()->fcgi_connections++;
+                pthread_mutex_unlock(&lock);
+                INFO("fastcgi %s: new connection, %d request(s) at a time", address.c_str(), streams);
+                return conn;
+            }
+            pthread_cond_wait(&cond, &lock);
+        }
+    }
+
+    void Release(const std::shared_ptr<FastCgiConn> &conn, bool ok)
+    {
+        pthread_mutex_lock(&lock);
+        conn->active--;
+        if (ok)
+        {
+            conn->served++;
+        }
+        if (conn->broken && conn->active == 0)
+        {
+            conns.erase(std::find(conns.begin(), conns.end(), conn));
+            ServerStats::getinstance()->fcgi_connections--;
+        }
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&lock);
+    }
+
+    // 连接出错：作废连接，上面所有进行中的请求都失败，正在读的线程也立即返回。调用时持有 conn->lock
+    static void Break(FastCgiConn *conn)
+    {
+        conn->broken = true;
+        shutdown(conn->fd, SHUT_RDWR);
+        for (auto &iter : conn->pending)
+        {
+            iter.second->done = true;
+            iter.second->failed = true;
+        }
+        pthread_cond_broadcast(&conn->cond);
+    }
+
+    // 读取连接上的记录并分发给各个请求，直到 mine 结束；连接出错返回 false
+    static bool ReadRecords(FastCgiConn *conn, FastCgiResult *mine)
+    {
+        while (true)
+        {
+            while (conn->inbuf.ReadableSize() >= FCGI_HEADER_LEN)
+            {
+                const uint8_t *h = (const uint8_t *)conn->inbuf.Peek();
+                size_t len = ((size_t)h[4] << 8) | h[5];
+                size_t total = FCGI_HEADER_LEN + len + h[6];
+                if (conn->inbuf.ReadableSize() < total)
+                {
+                    break;
+                }
+                if (h[0] != FCGI_VERSION_1)
+                {
+                    return false;
+                }
+                uint8_t type = h[1];
+                uint16_t id = ((uint16_t)h[2] << 8) | h[3];
+                const char *content = (const char *)h + FCGI_HEADER_LEN;
+                pthread_mutex_lock(&conn->lock);
+                bool finished = false;
+                auto iter = conn->pending.find(id);
+                if (iter != conn->pending.end()) // 别的类型（比如迟到的 FCGI_GET_VALUES_RESULT）和已经放弃的请求忽略
+                {
+                    FastCgiResult *result = iter->second;
+                    if (type == FCGI_STDOUT)
+                    {
+                        result->out.append(content, len);
+                    }
+                    else if (type == FCGI_STDERR)
+                    {
+                        result->err.append(content, len);
+                    }
+                    else if (type == FCGI_END_REQUEST && len >= 5)
+                    {
+                        const uint8_t *body = (const uint8_t *)content;
+                        result->app_status = ((uint32_t)body[0] << 24) | ((uint32_t)body[1] << 16) | ((uint32_t)body[2] << 8) | body[3];
+                        result->protocol_status = body[4];
+                        result->done = true;
+                        if (result != mine)
+                        {
+                            pthread_cond_broadcast(&conn->cond);
+                        }
+                    }
+                }
+                finished = mine->done;
+                pthread_mutex_unlock(&conn->lock);
+                conn->inbuf.Retrieve(total);
+                if (finished)
+                {
+                    return true;
+                }
+            }
+            ssize_t s = conn->inbuf.ReadFd(conn->fd);
+            if (s < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (s <= 0)
+            {
+                return false; // 后端关闭连接，或者超过 FCGI_IO_TIMEOUT 没有数据
+            }
+        }
+    }
+
+    // 在 conn 上执行一个请求，等到它结束；连接出错返回 false
+    bool Execute(FastCgiConn *conn, const FastCgiParams &params, const std::string &body, FastCgiResult &result)
+    {
+        pthread_mutex_lock(&conn->lock);
+        if (conn->broken)
+        {
+            pthread_mutex_unlock(&conn->lock);
+            return false;
+        }
+        uint16_t id;
+        do
+        {
+            id = ++conn->next_id;
+        } while (id == 0 || conn->pending.count(id) > 0);
+        conn->pending[id] = &result;
+        pthread_mutex_unlock(&conn->lock);
+
+        // 请求的全部记录拼在一起，一次写出
+        std::string out;
+        out.reserve(FCGI_HEADER_LEN * 6 + params.Data().size() + body.size() + 16);
+        char begin[8] = {0, FCGI_RESPONDER, FCGI_KEEP_CONN, 0, 0, 0, 0, 0};
+        AppendRecord(out, FCGI_BEGIN_REQUEST, id, begin, sizeof(begin));
+        AppendStream(out, FCGI_PARAMS, id, params.Data());
+        AppendStream(out, FCGI_STDIN, id, body);
+        pthread_mutex_lock(&conn->write_lock);
+        bool written = WriteAll(conn->fd, out);
+        pthread_mutex_unlock(&conn->write_lock);
+
+        pthread_mutex_lock(&conn->lock);
+        if (!written)
+        {
+            Break(conn);
+        }
+        while (!result.done)
+        {
+            if (!conn->reading)
+            {
+                conn->reading = true;
+                pthread_mutex_unlock(&conn->lock);
+                bool ok = ReadRecords(conn, &result);
+                pthread_mutex_lock(&conn->lock);
+                conn->reading = false;
+                if (!ok)
+                {
+                    Break(conn);
+                }
+                pthread_cond_broadcast(&conn->cond); // 交给下一个还在等的线程读
+                continue;
+            }
+            pthread_cond_wait(&conn->cond, &conn->lock);
+        }
+        conn->pending.erase(id);
+        pthread_mutex_unlock(&conn->lock);
+        return !result.failed;
+    }
+
+public:
+    FastCgiBackend(const std::string &_address, int _max_conns)
+        : address(_address), addrlen(0), max_conns(_max_conns > 0 ? _max_conns : FCGI_MAX_CONNS), connecting(0)
+    {
+        pthread_mutex_init(&lock, nullptr);
+        pthread_cond_init(&cond, nullptr);
+    }
+
+    bool Init()
+    {
+        return ParseAddress();
+    }
+
+    const std::string &Address()
+    {
+        return address;
+    }
+
+    // 执行一个请求：返回 FCGI_OK、FCGI_UNAVAILABLE 或 FCGI_FAILED
+    // 复用的连接可能已经被后端关掉了：什么都没收到就出错时换一个连接重试一次；
+    // 后端回答不能多路复用（FCGI_CANT_MPX_CONN）时这个连接改为一次一个请求，重试
+    int Request(const FastCgiParams &params, const std::string &body, FastCgiResult &result)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            std::shared_ptr<FastCgiConn> conn = Acquire();
+            if (!conn)
+            {
+                return FCGI_UNAVAILABLE; // 重试时也是这样：上一次的请求后端没有收到
+            }
+            pthread_mutex_lock(&lock);
+            bool reused = conn->served > 0;
+            pthread_mutex_unlock(&lock);
+            result.Reset();
+            bool ok = Execute(conn.get(), params, body, result);
+            if (ok && result.protocol_status == FCGI_CANT_MPX_CONN)
+            {
+                pthread_mutex_lock(&lock);
+                conn->streams = 1;
+                pthread_mutex_unlock(&lock);
+                Release(conn, false);
+                continue;
+            }
+            Release(conn, ok);
+            if (ok)
+            {
+                return FCGI_OK;
+            }
+            if (!reused || !result.out.empty())
+            {
+                break;
+            }
+        }
+        WARN("fastcgi %s: request failed", address.c_str());
+        return FCGI_FAILED;
+    }
+};
+
+// 配置的 FastCGI 路由：URI 路径前缀（"/app" 匹配 /app 和 /app/...）或者后缀（"*.php"）对应一个后端
+// 同一个地址的路由共用一个后端和它的连接池；没有匹配的路径仍然每个请求启动一次 CGI 程序
+class FastCgi
+{
+private:
+    struct Route
+    {
+        std::string pattern; // 前缀，或者后缀（去掉了开头的 "*"）
+        bool suffix;
+        FastCgiBackend *backend;
+    };
+
+    std::vector<Route> routes; // 前缀按长度从长到短排列，先匹配更具体的
+    std::vector<std::unique_ptr<FastCgiBackend>> backends;
+
+    FastCgi() {}
+
+    FastCgi(const FastCgi &) = delete;
+
+public:
+    static FastCgi *getinstance()
+    {
+        static FastCgi fcgi;
+        return &fcgi;
+    }
+
+    // 添加一条路由 "pattern=address"，在启动时调用；格式不对或者地址无法解析时返回 false
+    bool Add(const std::string &spec, int max_conns)
+    {
+        size_t eq = spec.find('=');
+        if (eq == std::string::npos || eq == 0)
+        {
+            return false;
+        }
+        Route route;
+        route.pattern = spec.substr(0, eq);
+        route.suffix = route.pattern[0] == '*';
+        if (route.suffix)
+        {
+            route.pattern.erase(0, 1);
+        }
+        else if (route.pattern[0] != '/')
+        {
+            return false;
+        }
+        else if (route.pattern.size() > 1 && route.pattern.back() == '/')
+        {
+            route.pattern.pop_back();
+        }
+        std::string address = spec.substr(eq + 1);
+        route.backend = nullptr;
+        for (auto &backend : backends)
+        {
+            if (backend->Address() == address)
+            {
+                route.backend = backend.get();
+            }
+        }
+        if (route.backend == nullptr)
+        {
+            std::unique_ptr<FastCgiBackend> backend(new FastCgiBackend(address, max_conns));
+            if (!backend->Init())
+            {
+                return false;
+            }
+            route.backend = backend.get();
+            backends.push_back(std::move(backend));
+        }
+        routes.push_back(route);
+        std::stable_sort(routes.begin(), routes.end(), [](const Route &a, const Route &b) {
+            return a.suffix < b.suffix || (a.suffix == b.suffix && a.pattern.size() > b.pattern.size());
+        });
+        INFO("fastcgi: %s%s -> %s", route.suffix ? "*" : "", route.pattern.c_str(), address.c_str());
+        return true;
+    }
+
+    // 查找处理 path 的后端，没有返回 nullptr
+    // script_name 是路由匹配的部分，path_info 是剩下的部分（都指向 path）
+    FastCgiBackend *Match(std::string_view path, std::string_view &script_name, std::string_view &path_info)
+    {
+        for (auto &route : routes)
+        {
+            std::string_view pattern = route.pattern;
+            if (route.suffix)
+            {
+                if (path.size() >= pattern.size() && path.substr(path.size() - pattern.size()) == pattern)
+                {
+                    script_name = path;
+                    path_info = std::string_view();
+                    return route.backend;
+                }
+                continue;
+            }
+            if (pattern == "/")
+            {
+                script_name = std::string_view();
+                path_info = path;
+                return route.backend;
+            }
+            if (path.substr(0, pattern.size()) == pattern && (path.size() == pattern.size() || path[pattern.size()] == '/'))
+            {
+                script_name = path.substr(0, pattern.size());
+                path_info = path.substr(pattern.size());
+                return route.backend;
+            }
+        }
+        return nullptr;
+    }
+};
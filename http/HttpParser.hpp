@@ -0,0 +1,243 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <strings.h>
+#include "Scan.hpp"
+
+#define MAX_HEAD_SIZE (64 * 1024) // 请求行加请求报头的最大长度
+#define MAX_BODY_SIZE (8 * 1024 * 1024) // 请求正文（Content-Length）的最大长度，超过时回复 413 并关闭连接
+#define MAX_METHOD_SIZE 16        // 请求方法的最大长度
+
+// 一行请求报头 key: value
+struct HttpHeader
+{
+    std::string_view name;
+    std::string_view value;
+};
+
+// 请求行和请求报头的解析结果
+// 除了 method 指向自身保存的大写副本，其余 string_view 都直接指向连接输入缓冲区中的原始数据：
+// 从解析完成到这个请求处理完毕，输入缓冲区不会再读入数据，所以这些 string_view 一直有效
+struct HttpRequestHead
+{
+    std::string_view request_line; // 请求行 = 请求方法（post/get） + uri + 协议版本
+    std::string_view method;       // 方法（大写）
+    std::string_view uri;          // uri = path?args
+    std::string_view version;      // 协议版本
+    std::vector<HttpHeader> header_kv; // 请求报头，数量很少，顺序查找比哈希表更快且不需要申请节点
+    char method_buf[MAX_METHOD_SIZE];
+
+    // 按名称查找请求报头（名称不区分大小写），没有则返回空
+    std::string_view GetHeader(std::string_view name) const
+    {
+        for (auto &header : header_kv)
+        {
+            if (header.name.size() == name.size() && strncasecmp(header.name.data(), name.data(), name.size()) == 0)
+            {
+                return header.value;
+            }
+        }
+        return std::string_view();
+    }
+
+    // 以逗号分隔的列表型请求报头（如 Connection: close, TE）中是否有某个选项：
+    // 同名的报头可能出现多次，每一项去掉两边的空格和制表符后比较，不区分大小写
+    bool HasHeaderToken(std::string_view name, std::string_view token) const
+    {
+        for (auto &header : header_kv)
+        {
+            if (header.name.size() != name.size() || strncasecmp(header.name.data(), name.data(), name.size()) != 0)
+            {
+                continue;
+            }
+            std::string_view list = header.value;
+            while (!list.empty())
+            {
+                size_t comma = list.find(',');
+                std::string_view item = list.substr(0, comma);
+                list.remove_prefix(comma == std::string_view::npos ? list.size() : comma + 1);
+                while (!item.empty() && (item.front() == ' ' || item.front() == '\t'))
+                    item.remove_prefix(1);
+                while (!item.empty() && (item.back() == ' ' || item.back() == '\t'))
+                    item.remove_suffix(1);
+                if (item.size() == token.size() && strncasecmp(item.data(), token.data(), token.size()) == 0)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void ClearHead()
+    {
+        request_line = method = uri = version = std::string_view();
+        header_kv.clear(); // 保留已分配的空间
+    }
+};
+
+// 增量式请求头解析器
+// 数据每到达一部分就从上次停下的位置继续扫描，只记录每一行在缓冲区中的偏移（缓冲区整理时数据会被移动，偏移依然有效），
+// 读到空行之后再一次性生成指向缓冲区的 string_view；常规路径上不拷贝数据，也不申请内存
+// 行尾的 "\r\n"、"\n" 或单独的 "\r" 都视为一行结束
+class HttpParser
+{
+public:
+    enum Result
+    {
+        PARSE_AGAIN, // 数据不够，等待更多数据
+        PARSE_DONE,  // 请求头解析完毕
+        PARSE_ERROR  // 请求头过长
+    };
+
+private:
+    struct LineSpan
+    {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    size_t scanned;              // 下一行的起始偏移，之前的数据已经扫描过
+    size_t head_length;          // 请求头（包括结尾空行）的总长度
+    std::vector<LineSpan> lines; // 已经扫描到的行：第一行是请求行，其余是请求报头
+
+private:
+    static bool IsSpace(char ch)
+    {
+        return ch == ' ' || ch == '\t';
+    }
+
+    // 从 line 的开头取出一个以空白分隔的单词
+    static std::string_view NextToken(std::string_view &line)
+    {
+        size_t i = 0;
+        while (i < line.size() && IsSpace(line[i]))
+            i++;
+        size_t j = i;
+        while (j < line.size() && !IsSpace(line[j]))
+            j++;
+        std::string_view token = line.substr(i, j - i);
+        line.remove_prefix(j);
+        return token;
+    }
+
+    static std::string_view Trim(std::string_view s)
+    {
+        while (!s.empty() && IsSpace(s.front()))
+            s.remove_prefix(1);
+        while (!s.empty() && IsSpace(s.back()))
+            s.remove_suffix(1);
+        return s;
+    }
+
+    // 请求头完整之后，生成指向缓冲区的解析结果
+    void Build(const char *data, HttpRequestHead &head)
+    {
+        // 请求行 = 方法 + uri + HTTP/版本，它们之间以空白分割
+        std::string_view line(data + lines[0].offset, lines[0].length);
+        head.request_line = line;
+        std::string_view method = NextToken(line);
+        head.uri = NextToken(line);
+        head.version = NextToken(line);
+
+        // 对请求方法全部转换成大写
+        if (method.size() < MAX_METHOD_SIZE)
+        {
+            for (size_t i = 0; i < method.size(); i++)
+            {
+                head.method_buf[i] = (method[i] >= 'a' && method[i] <= 'z') ? method[i] - 'a' + 'A' : method[i];
+            }
+            head.method = std::string_view(head.method_buf, method.size());
+        }
+        else
+        {
+            head.method = method; // 过长的方法不可能合法，原样保留，后面按非法请求处理
+        }
+
+        // 请求报头是 key: value 格式，没有冒号的行忽略
+        for (size_t i = 1; i < lines.size(); i++)
+        {
+            std::string_view header(data + lines[i].offset, lines[i].length);
+            const char *colon = Scan::FindChar(header.data(), header.data() + header.size(), ':');
+            if (colon == header.data() + header.size())
+            {
+                continue;
+            }
+            size_t pos = colon - header.data();
+            head.header_kv.push_back({Trim(header.substr(0, pos)), Trim(header.substr(pos + 1))});
+        }
+    }
+
+public:
+    HttpParser() : scanned(0), head_length(0)
+    {
+    }
+
+    // data/len：输入缓冲区中当前可读的全部数据（每次都从请求的起始位置开始传入）
+    Result Parse(const char *data, size_t len, HttpRequestHead &head)
+    {
+        const char *end = data + len;
+        while (scanned <= MAX_HEAD_SIZE)
+        {
+            const char *p = data + scanned;
+            const char *eol = Scan::FindLineEnd(p, end);
+            if (eol == end)
+            {
+                return len > MAX_HEAD_SIZE ? PARSE_ERROR : PARSE_AGAIN;
+            }
+            size_t term = 1;
+            if (*eol == '\r')
+            {
+                if (eol + 1 == end)
+                {
+                    return PARSE_AGAIN; // 要等下一个字符才知道是不是 "\r\n"
+                }
+                if (eol[1] == '\n')
+                {
+                    term = 2;
+                }
+            }
+
+            LineSpan span = {(uint32_t)scanned, (uint32_t)(eol - p)};
+            scanned += span.length + term;
+            if (span.length > 0)
+            {
+                lines.push_back(span);
+                continue;
+            }
+            if (lines.empty())
+            {
+                continue; // 请求行之前的空行（流水线请求之间可能夹着），跳过
+            }
+
+            // 读到空行，代表请求报头读完了
+            head_length = scanned;
+            Build(data, head);
+            return PARSE_DONE;
+        }
+        return PARSE_ERROR;
+    }
+
+    // 是否已经读到了请求行
+    bool HasRequestLine()
+    {
+        return !lines.empty();
+    }
+
+    // 请求头（包括结尾空行）的长度，解析完成后从输入缓冲区中取走这么多字节
+    size_t HeadLength()
+    {
+        return head_length;
+    }
+
+    // 准备解析下一个请求，保留已分配的空间
+    void Reset()
+    {
+        scanned = 0;
+        head_length = 0;
+        lines.clear();
+    }
+};
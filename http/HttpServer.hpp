@@ -2,23 +2,37 @@
 
 #include <iostream>
 #include <pthread.h>
+#include <vector>
 #include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
 #include "logs/mylog.h"
 #include "TcpServer.hpp"
-#include "Task.hpp"
-#include "ThreadPool.hpp"
-
-#define PORT 8081
+#include "Config.hpp"
+#include "Reactor.hpp"
 
 class HttpServer
 {
 private:
     int port; // 通过TCPserver绑定
+    ServerConfig config;
     bool stop;
 
+    // 多 reactor 模式下每个 reactor 运行在自己的线程中
+    static void *ReactorRoutine(void *args)
+    {
+        Reactor *reactor = (Reactor *)args;
+        reactor->Loop();
+        return nullptr;
+    }
+
 public:
-    HttpServer(int _port = PORT) : port(_port), stop(false)
+    HttpServer(int _port = PORT, const ServerConfig &_config = ServerConfig()) : port(_port), config(_config), stop(false)
     {
+        if (config.reactor_num <= 0)
+        {
+            config.reactor_num = sysconf(_SC_NPROCESSORS_ONLN);
+        }
     }
 
     void InitServer()
@@ -26,29 +40,71 @@ public:
         // 信号SIGPIPE需要进行忽略，如果不忽略，在写入时候，可能直接崩溃server
         // 即不忽略 SIGPIPE 信号，服务器在向已关闭的连接写入时会收到这个信号并立即崩溃。
         signal(SIGPIPE, SIG_IGN);
+
+        // 每个连接占用一个文件描述符，把软限制提高到硬限制，以支撑大量并发连接
+        struct rlimit rl;
+        if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max)
+        {
+            rl.rlim_cur = rl.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &rl);
+        }
+
+        INFO("scan kernel: %s", Scan::KernelName());
+
+        Placement::getinstance()->Init(config.affinity, config.irq_name, config.reactor_num);
+        // 静态文件和 CGI 各用一个线程池，慢的 CGI 程序不会占住处理静态文件的线程
+        ThreadPool *static_pool = ThreadPool::getinstance(POOL_STATIC, config.max_queued, config.pool_mode, config.min_threads, config.max_threads);
+        ThreadPool *cgi_pool = ThreadPool::getinstance(POOL_CGI, config.cgi_max_queued, config.pool_mode, config.cgi_min_threads, config.cgi_max_threads);
+        static_pool->SetQueueTarget(config.queue_target, config.queue_interval);
+        cgi_pool->SetQueueTarget(config.cgi_queue_target, config.queue_interval);
+        Placement::getinstance()->Print(std::max(static_pool->MaxThreads(), cgi_pool->MaxThreads()));
+
+        // FastCGI 路由：连接在第一个请求到来时才建立，后端晚于服务器启动也可以
+        for (auto &spec : config.fastcgi)
+        {
+            if (!FastCgi::getinstance()->Add(spec, config.fastcgi_conns))
+            {
+                FATAL("bad fastcgi route: %s", spec.c_str());
+                exit(6);
+            }
+        }
     }
 
-    // 在一个无限循环中，持续监听客户端的连接请求，一旦有客户端连接，就将其交给线程池中的线程来处理。
+    // 由 reactor 的事件循环负责获取连接和读写数据，只有读到完整请求的连接才交给线程池处理
     void Loop()
     {
-        TcpServer *tsvr = TcpServer::getinstance(port);
-        INFO("%s", "Loop begin");
-        while (!stop)
+        if (config.reactor_num == 1)
         {
-            struct sockaddr_in peer;
-            socklen_t len = sizeof(peer);
-            int sock = accept(tsvr->Sock(), (struct sockaddr *)&peer, &len); // 获取新连接
-            if (sock < 0)
+            TcpServer *tsvr = TcpServer::getinstance(port);
+            Reactor reactor(tsvr->Sock(), config);
+            if (!reactor.InitReactor())
             {
-                continue; // 获取套接字失败
+                exit(5);
             }
-            INFO("%s", "Get a new link");
-
-            // 获取一个任务
-            Task task(sock);
+            INFO("%s", "Loop begin");
+            reactor.Loop();
+            return;
+        }
 
-            // 推送到任务队列
-            ThreadPool::getinstance()->PushTask(task);
+        // 多 reactor：每个 reactor 有自己的监听套接字、I/O 后端和连接，热路径上互不共享
+        std::vector<pthread_t> tids;
+        for (int i = 0; i < config.reactor_num; i++)
+        {
+            TcpServer *tsvr = TcpServer::NewReusePortServer(port);
+            Placement::getinstance()->SteerListen(tsvr->Sock(), i);
+            Reactor *reactor = new Reactor(tsvr->Sock(), config, i);
+            pthread_t tid;
+            if (!reactor->InitReactor() || pthread_create(&tid, nullptr, ReactorRoutine, reactor) != 0)
+            {
+                FATAL("%s", "create reactor error!");
+                exit(5);
+            }
+            tids.push_back(tid);
+        }
+        INFO("Loop begin, %d reactors", config.reactor_num);
+        for (auto tid : tids)
+        {
+            pthread_join(tid, nullptr);
         }
     }
 
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <utility>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define JOB_INLINE_SIZE 48 // 不超过这个大小的闭包直接存放在 Job 里，不分配内存
+
+// 只能移动的无参可调用对象（类型擦除），线程池任务队列中的普通任务
+// 小的闭包（捕获几个指针、整数）放在内联缓冲区中，入队出队只是移动，不分配内存；
+// 更大的、或者移动时可能抛异常的闭包才放到堆上
+class Job
+{
+private:
+    // 每种闭包类型一组操作
+    struct Ops
+    {
+        void (*invoke)(void *self);
+        void (*move)(void *dst, void *src); // 移动到 dst 的缓冲区，并销毁 src
+        void (*destroy)(void *self);
+    };
+
+    template <class F>
+    static constexpr bool FitsInline()
+    {
+        return sizeof(F) <= JOB_INLINE_SIZE && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible<F>::value;
+    }
+
+    // 闭包直接放在缓冲区里
+    template <class F>
+    struct InlineOps
+    {
+        static void Invoke(void *self)
+        {
+            (*static_cast<F *>(self))();
+        }
+        static void Move(void *dst, void *src)
+        {
+            new (dst) F(std::move(*static_cast<F *>(src)));
+            static_cast<F *>(src)->~F();
+        }
+        static void Destroy(void *self)
+        {
+            static_cast<F *>(self)->~F();
+        }
+        static constexpr Ops ops = {Invoke, Move, Destroy};
+    };
+
+    // 缓冲区里只放指向堆上闭包的指针
+    template <class F>
+    struct HeapOps
+    {
+        static void Invoke(void *self)
+        {
+            (**static_cast<F **>(self))();
+        }
+        static void Move(void *dst, void *src)
+        {
+            *static_cast<F **>(dst) = *static_cast<F **>(src);
+        }
+        static void Destroy(void *self)
+        {
+            delete *static_cast<F **>(self);
+        }
+        static constexpr Ops ops = {Invoke, Move, Destroy};
+    };
+
+    alignas(std::max_align_t) unsigned char storage[JOB_INLINE_SIZE];
+    const Ops *ops; // 为空表示没有闭包
+
+    void Clear()
+    {
+        if (ops != nullptr)
+        {
+            ops->destroy(storage);
+            ops = nullptr;
+        }
+    }
+
+public:
+    Job() : ops(nullptr) {}
+
+    template <class F, class D = typename std::decay<F>::type,
+              class = typename std::enable_if<!std::is_same<D, Job>::value>::type>
+    Job(F &&f)
+    {
+        if (FitsInline<D>())
+        {
+            new (storage) D(std::forward<F>(f));
+            ops = &InlineOps<D>::ops;
+        }
+        else
+        {
+            *reinterpret_cast<D **>(storage) = new D(std::forward<F>(f));
+            ops = &HeapOps<D>::ops;
+        }
+    }
+
+    Job(Job &&other) noexcept : ops(other.ops)
+    {
+        if (ops != nullptr)
+        {
+            ops->move(storage, other.storage);
+            other.ops = nullptr;
+        }
+    }
+
+    Job &operator=(Job &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Clear();
+            ops = other.ops;
+            if (ops != nullptr)
+            {
+                ops->move(storage, other.storage);
+                other.ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Job(const Job &) = delete;
+    Job &operator=(const Job &) = delete;
+
+    explicit operator bool() const
+    {
+        return ops != nullptr;
+    }
+
+    void operator()()
+    {
+        ops->invoke(storage);
+    }
+
+    ~Job()
+    {
+        Clear();
+    }
+};
+
+// Future 和执行任务的一方共享的结果：一次分配，引用计数，完成时用 futex 唤醒等待的线程
+template <class T>
+class FutureState
+{
+private:
+    typedef typename std::conditional<std::is_void<T>::value, char, T>::type Value;
+
+    std::atomic<int> refs;
+    std::atomic<uint32_t> ready; // futex 字：0 未完成，1 已完成
+    std::atomic<bool> waiting;   // 有线程在 futex 上等待，完成时才需要系统调用
+    std::optional<Value> value;
+    std::exception_ptr error;
+
+    void Finish()
+    {
+        ready.store(1, std::memory_order_seq_cst); // 和 Wait 中对 waiting 的写配对
+        if (waiting.load(std::memory_order_seq_cst))
+        {
+            syscall(SYS_futex, (uint32_t *)&ready, FUTEX_WAKE | FUTEX_PRIVATE_FLAG, INT32_MAX, nullptr, nullptr, 0);
+        }
+    }
+
+public:
+    FutureState() : refs(2), ready(0), waiting(false) {}
+
+    void Release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete this;
+        }
+    }
+
+    bool Ready()
+    {
+        return ready.load(std::memory_order_acquire) != 0;
+    }
+
+    void Wait()
+    {
+        while (!Ready())
+        {
+            waiting.store(true, std::memory_order_seq_cst);
+            syscall(SYS_futex, (uint32_t *)&ready, FUTEX_WAIT | FUTEX_PRIVATE_FLAG, 0, nullptr, nullptr, 0);
+        }
+    }
+
+    // 执行 f，保存返回值或者异常
+    template <class F>
+    void Run(F &f)
+    {
+        try
+        {
+            if constexpr (std::is_void<T>::value)
+            {
+                f();
+                value.emplace('\0');
+            }
+            else
+            {
+                value.emplace(f());
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        Finish();
+    }
+
+    // 任务没有执行就被销毁了
+    void Abandon()
+    {
+        error = std::make_exception_ptr(std::runtime_error("job destroyed before it ran"));
+        Finish();
+    }
+
+    T Take()
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        if constexpr (!std::is_void<T>::value)
+        {
+            return std::move(*value);
+        }
+    }
+};
+
+// ThreadPool::Submit 返回的结果，只能移动
+// Get() 等待任务完成并取出返回值（任务抛出的异常在这里重新抛出），只能调用一次；队列满了没有提交成功时 Valid() 为 false
+template <class T>
+class Future
+{
+private:
+    FutureState<T> *state;
+
+public:
+    Future() : state(nullptr) {}
+
+    explicit Future(FutureState<T> *_state) : state(_state) {}
+
+    Future(Future &&other) noexcept : state(other.state)
+    {
+        other.state = nullptr;
+    }
+
+    Future &operator=(Future &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (state != nullptr)
+            {
+                state->Release();
+            }
+            state = other.state;
+            other.state = nullptr;
+        }
+        return *this;
+    }
+
+    Future(const Future &) = delete;
+    Future &operator=(const Future &) = delete;
+
+    bool Valid()
+    {
+        return state != nullptr;
+    }
+
+    bool Ready()
+    {
+        return state->Ready();
+    }
+
+    void Wait()
+    {
+        state->Wait();
+    }
+
+    T Get()
+    {
+        state->Wait();
+        FutureState<T> *s = state;
+        state = nullptr;
+        struct Releaser
+        {
+            FutureState<T> *s;
+            ~Releaser() { s->Release(); }
+        } releaser{s};
+        return s->Take();
+    }
+
+    ~Future()
+    {
+        if (state != nullptr)
+        {
+            state->Release();
+        }
+    }
+};
+
+// 放进 Job 的闭包：执行 f，把结果交给 Future
+template <class F, class T>
+class PromiseJob
+{
+private:
+    F f;
+    FutureState<T> *state;
+
+public:
+    PromiseJob(F &&_f, FutureState<T> *_state) : f(std::move(_f)), state(_state) {}
+
+    PromiseJob(PromiseJob &&other) noexcept(std::is_nothrow_move_constructible<F>::value)
+        : f(std::move(other.f)), state(other.state)
+    {
+        other.state = nullptr;
+    }
+
+    PromiseJob(const PromiseJob &) = delete;
+
+    void operator()()
+    {
+        state->Run(f);
+        state->Release();
+        state = nullptr;
+    }
+
+    ~PromiseJob()
+    {
+        if (state != nullptr)
+        {
+            state->Abandon();
+            state->Release();
+        }
+    }
+};
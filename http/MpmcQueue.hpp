@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define CACHE_LINE_SIZE 64
+
+// 有界的多生产者多消费者无锁队列（Dmitry Vyukov 的环形队列）
+// 每个槽有一个序号：序号等于入队位置表示空闲，等于入队位置 + 1 表示已写入、等待出队
+// 生产者和消费者各自用 CAS 抢占位置，然后只访问自己抢到的槽，不需要锁
+// 入队位置、出队位置和每个槽各占一个缓存行，避免伪共享
+// 元素按移动存取，可以是只能移动的类型；入队失败时不会动传入的元素
+template <class T>
+class MpmcQueue
+{
+private:
+    struct alignas(CACHE_LINE_SIZE) Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::vector<Cell> buffer;
+    size_t mask;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueue_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeue_pos;
+
+    MpmcQueue(const MpmcQueue &) = delete;
+
+public:
+    // 容量向上取整到 2 的幂
+    MpmcQueue(size_t capacity) : enqueue_pos(0), dequeue_pos(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        std::vector<Cell> cells(size);
+        buffer.swap(cells);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+        {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t Capacity()
+    {
+        return mask + 1;
+    }
+
+    // 当前的元素个数，并发修改时只是近似值
+    size_t Size()
+    {
+        size_t head = dequeue_pos.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    // 队列满了返回 false
+    template <class U>
+    bool TryPush(U &&data)
+    {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 这个槽上一轮的数据还没被取走
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed); // 被别的生产者抢先了
+            }
+        }
+        cell->data = std::forward<U>(data);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队列空了返回 false
+    bool TryPop(T &data)
+    {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true)
+        {
+            cell = &buffer[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // 这个槽还没有写入
+            }
+            else
+            {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        data = std::move(cell->data);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// 让空闲的消费者在 futex 上睡眠，生产者只在确实有消费者睡眠、并且还没有被叫醒时才唤醒
+// 已经叫醒但还没来得及运行的消费者不会被重复唤醒（它醒来后会一直取到队列为空才再次睡眠），
+// 所以消费者都在忙或者都已经被叫醒时，入队不需要任何系统调用
+// 用法（消费者）：
+//     while (!queue.TryPop(x)) {
+//         uint32_t key = ec.PrepareWait();
+//         if (queue.TryPop(x)) { ec.CancelWait(); break; }
+//         ec.Wait(key);
+//     }
+// 用法（生产者）：queue.TryPush(x) 成功后调用 ec.Notify()
+class EventCount
+{
+private:
+    static const uint64_t WAITER = 1;          // state 的低 32 位：准备睡眠或正在睡眠的消费者数
+    static const uint64_t SIGNAL = 1ULL << 32; // state 的高 32 位：已经发出、还没被消费者领取的唤醒数
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> epoch; // futex 字：每次唤醒加一
+    std::atomic<uint64_t> state;
+
+    static void Futex(std::atomic<uint32_t> *addr, int op, uint32_t val, const struct timespec *timeout = nullptr)
+    {
+        syscall(SYS_futex, (uint32_t *)addr, op | FUTEX_PRIVATE_FLAG, val, timeout, nullptr, 0);
+    }
+
+    // 消费者不再等待：减少等待数，顺便领取一个唤醒（如果有）
+    void Leave()
+    {
+        uint64_t s = state.load(std::memory_order_relaxed);
+        uint64_t next;
+        do
+        {
+            next = s - WAITER - ((s >> 32) > 0 ? SIGNAL : 0);
+        } while (!state.compare_exchange_weak(s, next, std::memory_order_relaxed));
+    }
+
+public:
+    EventCount() : epoch(0), state(0) {}
+
+    // 宣布要睡眠，返回当前的 epoch；之后必须再检查一次队列，再调用 Wait 或 CancelWait
+    uint32_t PrepareWait()
+    {
+        state.fetch_add(WAITER, std::memory_order_seq_cst);
+        uint32_t key = epoch.load(std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 之后对队列的检查不能提前到宣布睡眠之前
+        return key;
+    }
+
+    void CancelWait()
+    {
+        Leave();
+    }
+
+    // PrepareWait 之后如果有生产者调用了 Notify，epoch 已经变了，futex 会立即返回
+    // timeout_ms 为负数表示一直等待；超时返回之后调用者同样要重新检查队列
+    void Wait(uint32_t key, int timeout_ms = -1)
+    {
+        if (timeout_ms < 0)
+        {
+            Futex(&epoch, FUTEX_WAIT, key);
+        }
+        else
+        {
+            struct timespec ts = {timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000};
+            Futex(&epoch, FUTEX_WAIT, key, &ts);
+        }
+        Leave();
+    }
+
+    // 有消费者在睡眠、并且还没有都被叫醒时，唤醒一个
+    void Notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst); // 和消费者的 PrepareWait 配对：要么我们看到它在等待，要么它看到新数据
+        uint64_t s = state.load(std::memory_order_relaxed);
+        do
+        {
+            if ((s >> 32) >= (s & 0xffffffff))
+            {
+                return;
+            }
+        } while (!state.compare_exchange_weak(s, s + SIGNAL, std::memory_order_relaxed));
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        Futex(&epoch, FUTEX_WAKE, 1);
+    }
+};
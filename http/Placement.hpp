@@ -0,0 +1,362 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <sched.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include "logs/mylog.h"
+
+#define AFFINITY_NONE 0  // 不绑定 CPU，由内核调度
+#define AFFINITY_CORES 1 // reactor 各绑定一个 CPU（在 NUMA 节点之间轮流），工作线程绑定到对应 reactor 所在的节点
+#define AFFINITY_IRQ 2   // 同上，但 reactor 绑定到网卡接收队列中断所在的 CPU
+
+#define MPOL_PREFERRED_MODE 1 // set_mempolicy 的 MPOL_PREFERRED，<numaif.h> 属于 libnuma，这里直接用系统调用
+
+// reactor 和工作线程的 CPU / NUMA 节点放置
+// 拓扑从 /sys/devices/system 读取，不依赖 libnuma；线程启动时调用 PinReactor / PinWorker 绑定自己，
+// 同时把内存策略设为优先本节点：连接的缓冲区由 reactor 分配、响应由工作线程构建，都落在线程所在节点的内存上
+// 放置计划在启动时打印
+class Placement
+{
+private:
+    int mode;
+    std::vector<std::vector<int>> nodes; // 每个节点的 CPU，按节点编号索引（编号可能不连续，中间的节点为空）
+    std::vector<int> cpu_node;           // CPU -> 节点
+    std::vector<int> reactor_cpus;       // 第 i 个 reactor 绑定的 CPU
+    std::vector<std::string> reactor_irqs; // 第 i 个 reactor 对应的中断（AFFINITY_IRQ）
+    int reactor_num;
+
+    Placement() : mode(AFFINITY_NONE), reactor_num(1) {}
+
+    Placement(const Placement &) = delete;
+
+    // 解析 "0-3,8-11" 形式的 CPU（或 NUMA 节点）列表
+    static std::vector<int> ParseList(const std::string &list)
+    {
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            if (range.empty() || !isdigit((unsigned char)range[0]))
+            {
+                continue;
+            }
+            size_t dash = range.find('-');
+            int lo = std::stoi(range.substr(0, dash));
+            int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+            for (int cpu = lo; cpu <= hi; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    static std::string ReadLine(const std::string &path)
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    // 读取 NUMA 拓扑；没有 NUMA 信息的机器上所有 CPU 属于节点 0
+    // 节点编号可能不连续（离线的节点、只有内存的节点），按 node/online 列出的编号读取，不在第一个空缺处停止
+    void LoadTopology()
+    {
+        std::vector<int> online = ParseList(ReadLine("/sys/devices/system/cpu/online"));
+        if (online.empty())
+        {
+            for (long i = 0; i < sysconf(_SC_NPROCESSORS_ONLN); i++)
+            {
+                online.push_back(i);
+            }
+        }
+        int max_cpu = 0;
+        for (int cpu : online)
+        {
+            max_cpu = std::max(max_cpu, cpu);
+        }
+        cpu_node.assign(max_cpu + 1, -1);
+        for (int node : ParseList(ReadLine("/sys/devices/system/node/online")))
+        {
+            if (node >= (int)nodes.size())
+            {
+                nodes.resize(node + 1);
+            }
+            std::string list = ReadLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            for (int cpu : ParseList(list))
+            {
+                if (cpu <= max_cpu)
+                {
+                    cpu_node[cpu] = node;
+                }
+            }
+        }
+        if (nodes.empty())
+        {
+            nodes.emplace_back();
+        }
+        for (int cpu : online)
+        {
+            if (cpu_node[cpu] < 0)
+            {
+                cpu_node[cpu] = 0;
+            }
+            nodes[cpu_node[cpu]].push_back(cpu);
+        }
+    }
+
+    // 名字包含 name 的中断（网卡接收队列）当前的 CPU，按中断号的顺序
+    void LoadIrqCpus(const std::string &name)
+    {
+        std::ifstream in("/proc/interrupts");
+        std::string line;
+        std::getline(in, line); // 表头
+        while (std::getline(in, line))
+        {
+            if (line.find(name) == std::string::npos)
+            {
+                continue;
+            }
+            std::string irq = line.substr(0, line.find(':'));
+            irq.erase(0, irq.find_first_not_of(' '));
+            std::string list = ReadLine("/proc/irq/" + irq + "/effective_affinity_list");
+            if (list.empty())
+            {
+                list = ReadLine("/proc/irq/" + irq + "/smp_affinity_list");
+            }
+            std::vector<int> cpus = ParseList(list);
+            if (cpus.empty() || cpus[0] >= (int)cpu_node.size())
+            {
+                continue;
+            }
+            reactor_cpus.push_back(cpus[0]);
+            reactor_irqs.push_back(line.substr(line.find_last_of(' ') + 1) + " (irq " + irq + ")");
+        }
+    }
+
+    // 每个节点轮流取一个 CPU，reactor 均匀分布在各个节点上
+    void InterleaveCpus()
+    {
+        for (size_t i = 0;; i++)
+        {
+            bool any = false;
+            for (auto &node : nodes)
+            {
+                if (i < node.size())
+                {
+                    reactor_cpus.push_back(node[i]);
+                    any = true;
+                }
+            }
+            if (!any)
+            {
+                break;
+            }
+        }
+    }
+
+    static std::string FormatList(const std::vector<int> &cpus)
+    {
+        std::string out;
+        for (size_t i = 0; i < cpus.size(); i++)
+        {
+            size_t j = i;
+            while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1)
+            {
+                j++;
+            }
+            out += (out.empty() ? "" : ",") + std::to_string(cpus[i]);
+            if (j > i)
+            {
+                out += "-" + std::to_string(cpus[j]);
+            }
+            i = j;
+        }
+        return out;
+    }
+
+    static bool SetAffinity(const std::vector<int> &cpus)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus)
+        {
+            CPU_SET(cpu, &set);
+        }
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    // 当前线程之后分配的内存优先使用 node 节点（内存不够时退回其他节点）
+    static bool PreferNode(int node)
+    {
+        unsigned long mask[16] = {0};
+        if (node < 0 || node >= (int)(sizeof(mask) * 8))
+        {
+            return false;
+        }
+        mask[node / (sizeof(unsigned long) * 8)] |= 1UL << (node % (sizeof(unsigned long) * 8));
+        return syscall(SYS_set_mempolicy, MPOL_PREFERRED_MODE, mask, sizeof(mask) * 8 + 1) == 0;
+    }
+
+    void Pin(const std::vector<int> &cpus, int node, const char *who, int id)
+    {
+        if (!SetAffinity(cpus))
+        {
+            WARN("%s %d: set cpu affinity to %s failed", who, id, FormatList(cpus).c_str());
+        }
+        if (nodes.size() > 1 && !PreferNode(node))
+        {
+            WARN("%s %d: set memory policy to node %d failed", who, id, node);
+        }
+    }
+
+public:
+    static Placement *getinstance()
+    {
+        static Placement placement;
+        return &placement;
+    }
+
+    // 在创建 reactor 和线程池之前调用一次；irq_name 只在 AFFINITY_IRQ 下使用
+    void Init(int _mode, const std::string &irq_name, int _reactor_num)
+    {
+        mode = _mode;
+        reactor_num = _reactor_num;
+        if (mode == AFFINITY_NONE)
+        {
+            return;
+        }
+        LoadTopology();
+        if (mode == AFFINITY_IRQ)
+        {
+            LoadIrqCpus(irq_name);
+            if (reactor_cpus.empty())
+            {
+                WARN("no interrupt matches \"%s\", place reactors by cores", irq_name.c_str());
+                mode = AFFINITY_CORES;
+            }
+        }
+        if (mode == AFFINITY_CORES)
+        {
+            InterleaveCpus();
+        }
+    }
+
+    bool Enabled()
+    {
+        return mode != AFFINITY_NONE;
+    }
+
+    int ReactorCpu(int index)
+    {
+        return reactor_cpus[index % reactor_cpus.size()];
+    }
+
+    // 工作线程 slot 跟随第 slot % reactor_num 个 reactor 所在的节点，可以在节点内的 CPU 之间迁移
+    int WorkerNode(int slot)
+    {
+        return cpu_node[ReactorCpu(slot % reactor_num)];
+    }
+
+    int ReactorNum()
+    {
+        return reactor_num;
+    }
+
+    // 两个工作线程是否绑定在同一个节点上；不绑定时线程不属于任何节点
+    bool SameNode(int a, int b)
+    {
+        return Enabled() && WorkerNode(a) == WorkerNode(b);
+    }
+
+    // 由 reactor 线程自己调用
+    void PinReactor(int index)
+    {
+        if (Enabled())
+        {
+            int cpu = ReactorCpu(index);
+            Pin(std::vector<int>(1, cpu), cpu_node[cpu], "reactor", index);
+        }
+    }
+
+    // 由工作线程自己调用
+    void PinWorker(int slot)
+    {
+        if (Enabled())
+        {
+            int node = WorkerNode(slot);
+            Pin(nodes[node], node, "worker", slot);
+        }
+    }
+
+    // 把 reactor 的监听套接字（SO_REUSEPORT）引导到它所在的 CPU：6.2 以上的内核在同一组监听套接字中
+    // 优先选择 SO_INCOMING_CPU 和处理接收中断的 CPU 相同的那个，连接从中断到 accept 到读写都在同一个核上
+    void SteerListen(int sock, int index)
+    {
+        if (!Enabled())
+        {
+            return;
+        }
+        int cpu = ReactorCpu(index);
+        if (setsockopt(sock, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) < 0)
+        {
+            WARN("reactor %d: set SO_INCOMING_CPU failed", index);
+        }
+    }
+
+    // 打印放置计划：每个 reactor 的 CPU，以及每个节点上的工作线程
+    void Print(int max_workers)
+    {
+        if (!Enabled())
+        {
+            INFO("%s", "placement: none, threads float across all cpus");
+            return;
+        }
+        for (size_t node = 0; node < nodes.size(); node++)
+        {
+            if (!nodes[node].empty())
+            {
+                INFO("placement: node %zu cpus %s", node, FormatList(nodes[node]).c_str());
+            }
+        }
+        for (int i = 0; i < reactor_num; i++)
+        {
+            int cpu = ReactorCpu(i);
+            if (mode == AFFINITY_IRQ)
+            {
+                INFO("placement: reactor %d -> cpu %d (node %d), rx %s", i, cpu, cpu_node[cpu],
+                     reactor_irqs[i % reactor_irqs.size()].c_str());
+            }
+            else
+            {
+                INFO("placement: reactor %d -> cpu %d (node %d)", i, cpu, cpu_node[cpu]);
+            }
+        }
+        for (size_t node = 0; node < nodes.size(); node++)
+        {
+            std::vector<int> slots;
+            for (int slot = 0; slot < max_workers; slot++)
+            {
+                if (WorkerNode(slot) == (int)node)
+                {
+                    slots.push_back(slot);
+                }
+            }
+            if (!slots.empty())
+            {
+                INFO("placement: worker slots %s -> node %zu cpus %s", FormatList(slots).c_str(), node,
+                     FormatList(nodes[node]).c_str());
+            }
+        }
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#define MAX_EVENTS 1024 // 每次等待最多取出的就绪事件数
+
+#define BACKEND_EPOLL 0 // I/O 后端：边缘触发的 epoll
+#define BACKEND_URING 1 // I/O 后端：io_uring
+
+// 一个就绪事件
+// 监听套接字的 ptr 为 nullptr：res >= 0 表示后端已经替我们 accept 到的新连接，res < 0 表示需要自己 accept
+// 连接的 ptr 指向它的 EndPoint，events 使用 EPOLLIN/EPOLLOUT/EPOLLERR（与 poll 的取值相同）
+struct PollEvent
+{
+    void *ptr;
+    uint32_t events;
+    int res;
+};
+
+// reactor 使用的 I/O 多路复用后端
+// 连接上的事件都是一次性的：就绪一次之后必须重新 Mod，保证同一时刻只有一个线程在操作某个 EndPoint
+// Mod 可能在线程池的线程中调用，其余接口只在 reactor 线程中调用
+// 例外：CGI 子进程的管道和 pidfd 由启动它的工作线程 Add（ptr 带 CgiProcess 的标记，见 CgiProcess.hpp）
+class Poller
+{
+public:
+    virtual bool Init() = 0;
+    virtual const char *Name() = 0;
+
+    // 开始监听新连接（监听套接字是非阻塞的）
+    virtual bool AddListen(int fd) = 0;
+    // 开始监听一个新连接的事件
+    virtual bool Add(int fd, uint32_t events, void *ptr) = 0;
+    // 重新设置连接关心的事件
+    virtual void Mod(int fd, uint32_t events, void *ptr) = 0;
+    // 不再监听连接：armed 表示连接还有一个没有就绪的事件
+    // 返回 true 表示之后还会收到一个 ptr 的事件，收到之前不能释放 ptr 指向的对象
+    virtual bool Del(int fd, void *ptr, bool armed) = 0;
+    // 等待就绪事件，timeout 为毫秒，-1 表示一直等待；返回事件个数，出错返回 -1
+    virtual int Wait(PollEvent *events, int max, int timeout) = 0;
+
+    virtual ~Poller() {}
+};
+
+// 边缘触发 + EPOLLONESHOT 的 epoll
+class EpollPoller : public Poller
+{
+private:
+    int epfd;
+    struct epoll_event evs[MAX_EVENTS];
+
+    bool Ctl(int op, int fd, uint32_t events, void *ptr)
+    {
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.ptr = ptr;
+        return epoll_ctl(epfd, op, fd, &ev) == 0;
+    }
+
+public:
+    EpollPoller() : epfd(-1) {}
+
+    bool Init() override
+    {
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        return epfd >= 0;
+    }
+
+    const char *Name() override
+    {
+        return "epoll";
+    }
+
+    // 监听套接字不用 EPOLLONESHOT，reactor 每次都 accept 到没有新连接为止
+    bool AddListen(int fd) override
+    {
+        return Ctl(EPOLL_CTL_ADD, fd, EPOLLIN | EPOLLET, nullptr);
+    }
+
+    bool Add(int fd, uint32_t events, void *ptr) override
+    {
+        return Ctl(EPOLL_CTL_ADD, fd, events | EPOLLET | EPOLLONESHOT, ptr);
+    }
+
+    void Mod(int fd, uint32_t events, void *ptr) override
+    {
+        Ctl(EPOLL_CTL_MOD, fd, events | EPOLLET | EPOLLONESHOT, ptr);
+    }
+
+    bool Del(int fd, void * /*ptr*/, bool /*armed*/) override
+    {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+        return false;
+    }
+
+    int Wait(PollEvent *events, int max, int timeout) override
+    {
+        int n = epoll_wait(epfd, evs, max < MAX_EVENTS ? max : MAX_EVENTS, timeout);
+        for (int i = 0; i < n; i++)
+        {
+            events[i].ptr = evs[i].data.ptr;
+            events[i].events = evs[i].events;
+            events[i].res = -1;
+        }
+        return n;
+    }
+
+    ~EpollPoller()
+    {
+        if (epfd >= 0)
+        {
+            close(epfd);
+        }
+    }
+};
@@ -1,24 +1,60 @@
 #include "Utill.hpp"
+#include "Buffer.hpp"
+#include "HttpParser.hpp"
+#include "Poller.hpp"
+#include "Timer.hpp"
+#include "Stats.hpp"
+#include "FastCgi.hpp"
+#include "Spawn.hpp"
+#include "CgiProcess.hpp"
 #include "logs/mylog.h"
 #include <vector>
-#include <unordered_map>
+#include <deque>
 #include <algorithm>
+#include <string_view>
+#include <charconv>
+#include <strings.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/wait.h>
+#include <sys/uio.h>
 #include <sys/sendfile.h>
+#include <sys/ioctl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #define LINE_END "\r\n"
-#define SEP ": "
 #define WEB_ROOT "wwwroot"
 #define HOME_PAGE "index.html"
-#define HTTP_VERSION "HTTP/1.0"
+#define HTTP_VERSION "HTTP/1.1"
 #define PAGE_404 "404.html"
+#define MAX_IOV 64 // 一次 writev 最多合并的数据段数
+#define SMALL_BODY_SIZE 4096 // 不超过这个大小的静态文件直接读入内存，和响应头一起用一次 writev 发送
+#define BODY_GROW_SIZE 65536 // 接收请求正文时缓冲区每次最多扩大的字节数，内存随收到的数据增长，而不是按客户端声明的长度一次分配
+#define SEND_QUOTA (1 << 20) // 每次可写事件最多用 sendfile/splice 发送的字节数，避免一个大文件下载独占 reactor
+#define STREAM_BUFFER_SIZE 65536 // 分块发送 CGI 输出时每个请求的缓冲区大小（一块的最大长度）
+#define CHUNK_HEAD_SIZE 10       // 块头（十六进制长度 + CRLF）预留的空间
+#define LAST_CHUNK "0" LINE_END LINE_END
 
 #define OK 200
 #define BAD_REQUEST 400
 #define NOT_FOUND 404
+#define PAYLOAD_TOO_LARGE 413
 #define SERVER_ERROR 500
+#define BAD_GATEWAY 502
+#define SERVICE_UNAVAILABLE 503
+
+#define RETRY_AFTER 1 // 过载时让客户端等待多少秒再重试
+
+// 过载时直接回复的 503 响应，预先拼好，不经过线程池，也不需要构建
+static const std::string SERVICE_UNAVAILABLE_RESPONSE =
+    HTTP_VERSION " 503 Service Unavailable" LINE_END
+    "Content-Type: text/html" LINE_END
+    "Content-Length: 19" LINE_END
+    "Retry-After: " + std::to_string(RETRY_AFTER) + LINE_END
+    "Connection: close" LINE_END
+    LINE_END
+    "Service Unavailable";
 
 // 状态码描述：传入状态码，获得状态码描述结果
 static std::string Code2Desc(int code)
@@ -32,6 +68,15 @@ static std::string Code2Desc(int code)
     case 404:
         desc = "Not Found";
         break;
+    case 413:
+        desc = "Payload Too Large";
+        break;
+    case 502:
+        desc = "Bad Gateway";
+        break;
+    case 503:
+        desc = "Service Unavailable";
+        break;
     default:
         break;
     }
@@ -39,52 +84,68 @@ static std::string Code2Desc(int code)
 }
 
 // 依照请求资源的后缀，构建HTTP响应的报头中Content-Type的类型（Content-Type: text/html）
-static std::string Suffix2Desc(const std::string &suffix)
+static const char *Suffix2Desc(std::string_view suffix)
 {
-    // static 只会初始化一次，可以进一步优化！完善资源类型
-    static std::unordered_map<std::string, std::string> suffix2desc = {
+    // 资源类型很少，顺序查找即可，不需要构造 std::string 去查哈希表
+    static const struct
+    {
+        std::string_view suffix;
+        const char *desc;
+    } suffix2desc[] = {
         {".html", "text/html"},
         {".css", "text/css"},
         {".js", "application/javascript"},
         {".jpg", "application/x-jpg"},
         {".xml", "application/xml"},
+        {".txt", "text/plain"},
     };
 
-    auto iter = suffix2desc.find(suffix);
-    if (iter != suffix2desc.end())
+    for (auto &iter : suffix2desc)
     {
-        return iter->second;
+        if (iter.suffix == suffix)
+        {
+            return iter.desc;
+        }
     }
     return "text/html";
 }
 
 // HTTP请求信息
-class HttpRequest
+// 请求行和请求报头的解析结果（request_line、method、uri、version、header_kv）见 HttpRequestHead，
+// 它们都指向连接的输入缓冲区，不做拷贝
+class HttpRequest : public HttpRequestHead
 {
 public:
-    // 接收到的请求信息
-    std::string request_line;                // 请求行 = 请求方法（post/get） + uri + 协议版本
-    std::vector<std::string> request_header; // 请求报头 = key: value
-    std::string blank;                       // 空行
-    std::string request_body;                // 请求正文
-
-    // 解析请求行的结果：请求行 = 方法 + uri + 协议版本
-    std::string method;  // 方法
-    std::string uri;     // uri = path?args
-    std::string version; // 协议版本
-
-    // 解析请求报头的结果：
-    std::unordered_map<std::string, std::string> header_kv; // 将每行数据存入map中
-    int content_length;                                     // 记录请求正文的大小
-    std::string path;                                       // 记录请求资源的路径
-    std::string suffix;                                     // 记录请求资源的后缀
-    std::string query_string;                               // 记录解析URI中 ? 后的内容
+    std::string request_body; // 请求正文
+
+    int content_length;            // 记录请求正文的大小
+    std::string path;              // 记录请求资源的路径
+    std::string_view suffix;       // 记录请求资源的后缀（指向 path）
+    std::string_view query_string; // 记录解析URI中 ? 后的内容
+    std::string_view script_name;  // FastCGI：匹配路由的路径部分
+    std::string_view path_info;    // FastCGI：路径中剩下的部分
 
     bool cgi; // 是否是CGI机制（是否需要http或相关程序作数据处理）
-    int size; // 正文的大小
+    off_t size; // 正文的大小（文件可能超过 2GB）
 
 public:
-    HttpRequest() : content_length(0), cgi(false) {}
+    HttpRequest() : content_length(0), cgi(false), size(0) {}
+
+    // 长连接处理下一个请求前清空上一个请求，clear 保留已分配的空间，避免重复申请内存
+    void Reset()
+    {
+        ClearHead();
+        request_body.clear();
+        content_length = 0;
+        path.clear();
+        suffix = std::string_view();
+        query_string = std::string_view();
+        script_name = std::string_view();
+        path_info = std::string_view();
+        cgi = false;
+        size = 0;
+    }
+
     ~HttpRequest() {}
 };
 
@@ -100,157 +161,613 @@ public:
 
     int status_code; // 状态码
     int fd;          //
+    // FastCGI 程序给出的响应：状态码、原因短语、Content-Type 和正文原样转发，不替换成错误页
+    bool from_app;
+    std::string reason;
+    std::string content_type;
+    int pipe_fd; // 流式发送的 CGI 输出管道（不属于响应，见 CgiProcess），-1 表示正文在 response_body 中
+    bool chunked; // 流式发送的正文使用分块编码（HTTP/1.1）
 
 public:
-    HttpResponse() : blank(LINE_END), status_code(OK), fd(-1) {}
+    HttpResponse() : blank(LINE_END), status_code(OK), fd(-1), from_app(false), pipe_fd(-1), chunked(false) {}
+
+    // 长连接处理下一个请求前清空上一个响应
+    void Reset()
+    {
+        status_line.clear();
+        response_header.clear();
+        response_body.clear();
+        status_code = OK;
+        from_app = false;
+        reason.clear();
+        content_type.clear();
+        pipe_fd = -1;
+        chunked = false;
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        fd = -1;
+    }
+
     ~HttpResponse() {}
 };
 
+// EndPoint 在 reactor 驱动下所处的阶段
+enum EndPointState
+{
+    STATE_RECV_LINE,   // 读取请求行
+    STATE_RECV_HEADER, // 读取请求报头
+    STATE_RECV_BODY,   // 读取请求正文
+    STATE_PROCESS      // 请求已读完整，交给线程池构建响应
+};
+
+// 连接在 reactor 中等待的阶段，每个阶段有各自的超时时间（见 ServerConfig）
+enum TimeoutPhase
+{
+    PHASE_NONE,         // 在线程池中处理，不计时
+    PHASE_REQUEST_LINE, // 等待请求行（新连接，或下一个请求已经到了一部分）
+    PHASE_HEADER,       // 等待请求报头
+    PHASE_BODY,         // 等待请求正文
+    PHASE_SEND,         // 等待发送响应
+    PHASE_IDLE,         // 长连接上一个响应已发送完，等待下一个请求
+    PHASE_CGI           // 等待 CGI 子进程（执行、输出或退出），从子进程启动开始计时，套接字没有在等待事件
+};
+
+// 解析完请求路径之后请求的去向
+enum RequestRoute
+{
+    ROUTE_NONE,   // 还没有解析路径
+    ROUTE_DONE,   // 解析时已经得到了结果（错误页、状态页）
+    ROUTE_STATIC, // 静态文件
+    ROUTE_CGI,    // CGI 程序，在 CGI 线程池中启动，由 reactor 驱动执行（见 CgiProcess）
+    ROUTE_FASTCGI // 交给常驻的 FastCGI 进程，和 CGI 一样在 CGI 线程池中执行
+};
+
+// HandlerHttpRequests 的结果
+enum HandleResult
+{
+    HANDLE_DONE,    // 响应已放入输出队列，等待发送
+    HANDLE_HANDOFF, // 遇到了 CGI 请求，交给 CGI 线程池从这个请求接着处理
+    HANDLE_PENDING  // CGI 子进程在执行，由 reactor 驱动，结束后 reactor 再把连接交给 CGI 线程池
+};
+
+// 输出队列中待发送的一段数据：内存中的数据（状态行+报头，或CGI正文），文件中的一段（静态资源，用 sendfile 发送），
+// 或者 CGI 的输出管道（流式发送，用 splice 发送）
+struct OutChunk
+{
+    std::string data; // 内存数据
+    int fd;           // 文件描述符，-1 表示这是内存数据
+    off_t offset;     // 文件已发送到的位置
+    off_t end;        // 文件发送的结束位置
+    bool pipe;        // fd 是 CGI 的标准输出管道（属于 CgiProcess），用 splice 发送到文件结束
+    bool chunked;     // pipe 按分块编码发送：data 是当前的一块，offset 是已发送到的位置，end 为 1 表示 data 是结束块
+
+    OutChunk() : fd(-1), offset(0), end(0), pipe(false), chunked(false) {}
+};
+
 // 读取请求，分析请求，构建响应
+// 套接字是非阻塞的：读写由 reactor 在就绪时驱动，数据不够时记录进度，等待下一次事件继续
 class EndPoint
 {
 private:
     int sock;                   // 文件标识符
+    Poller *poller;             // 所属 reactor 的 I/O 后端
     HttpRequest http_request;   // HTTP请求
     HttpResponse http_response; // HTTP响应
     bool stop;                  // 标记位
+    EndPointState state;        // 当前阶段
+    Buffer inbuffer;            // 输入缓冲区
+    HttpParser parser;          // 请求头解析器
+    bool keep_alive;            // 响应发送完之后是否保持连接
+    int request_count;          // 这个连接已经处理的请求数
+    int max_requests;           // 这个连接最多处理的请求数
+    unsigned home;              // 处理这个连接的请求时优先使用的工作线程（线程池的 work-stealing 模式）
+    TimerNode timer;            // 当前阶段的超时定时器，由 reactor 设置
+    TimeoutPhase timer_phase;   // 定时器对应的阶段
+    RequestRoute route;         // 当前请求的去向
+    FastCgiBackend *fcgi;       // ROUTE_FASTCGI 的后端
+    CgiProcess cgi;             // ROUTE_CGI 的子进程
+
+    std::deque<OutChunk> outqueue; // 输出队列：按请求的顺序存放待发送的响应
+    size_t out_offset;             // 队头内存数据已发送的字节数
+    bool sending;                  // 是否正在等待套接字可写
+    bool close_after_send;         // 输出队列发送完之后关闭连接
+    bool corked;                   // 套接字是否设置了 TCP_CORK
+    int cgi_output;                // CGI 输出的发送方式：CGI_OUTPUT_BUFFER、CGI_OUTPUT_SPLICE 或 CGI_OUTPUT_STREAM
+    bool status_page;              // 是否回答 STATUS_URI（服务器计数器），关闭时这个路径和其他路径一样查找文件
+    bool cgi_wait;                 // 输出队列停在 CGI 管道上：管道暂时没有数据，等子进程的输出
+    bool cgi_exit_wait;            // 分块发送的 CGI 输出已经读完，等子进程退出后按退出状态决定是否发送结束块
 
 private:
-    // 接收请求行
-    bool RecvHttpRequestLine()
+    // 从套接字读取一批数据到输入缓冲区：读到数据返回 true；暂无数据返回 false；对端关闭或出错时设置 stop
+    bool RecvToBuffer()
+    {
+        while (true)
+        {
+            ssize_t s = inbuffer.ReadFd(sock);
+            if (s > 0)
+            {
+                return true;
+            }
+            if (s < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (s == 0 || !Utill::WouldBlock())
+            {
+                stop = true;
+            }
+            return false;
+        }
+    }
+
+    // 接收请求行和请求报头：输入缓冲区中已经有完整的请求头时解析出来并返回 true，否则返回 false；请求头过长时设置 stop
+    bool RecvHttpRequestHead()
     {
-        // 引用请求行
+        HttpParser::Result ret = parser.Parse(inbuffer.Peek(), inbuffer.ReadableSize(), http_request);
+        if (ret == HttpParser::PARSE_AGAIN)
+        {
+            if (parser.HasRequestLine())
+            {
+                state = STATE_RECV_HEADER;
+            }
+            return false;
+        }
+        if (ret == HttpParser::PARSE_ERROR)
+        {
+            WARN("%s", "request head too large");
+            stop = true;
+            return false;
+        }
+
+        // 取走请求头：这里只移动读位置，数据还在内存中，解析结果可以继续使用
+        inbuffer.Retrieve(parser.HeadLength());
+        parser.Reset();
+
+        // 打印请求行和请求报头的信息
         auto &line = http_request.request_line;
+        INFO("%.*s", (int)line.size(), line.data());
+        for (auto &header : http_request.header_kv)
+        {
+            INFO("%.*s: %.*s", (int)header.name.size(), header.name.data(), (int)header.value.size(), header.value.data());
+        }
+        return true;
+    }
 
-        // 按行读取操作，成功则将结果存入 line（http_request.request_line）中
-        if (Utill::ReadLine(sock, line) > 0)
+    // 判断是否保持长连接：HTTP/1.1 默认保持，除非 Connection 中有 close；HTTP/1.0 只有 Connection 中有 keep-alive 才保持
+    // Connection 是以逗号分隔的选项列表（如 close, TE），逐项比较
+    void CheckKeepAlive()
+    {
+        if (http_request.version == "HTTP/1.1")
         {
-            line.resize(line.size() - 1);
-            // 打印请求行的信息
-            INFO("%s", http_request.request_line);
+            keep_alive = !http_request.HasHeaderToken("Connection", "close");
         }
         else
         {
-            stop = true; // 读取失败，标记位退出
+            keep_alive = http_request.HasHeaderToken("Connection", "keep-alive");
+        }
+
+        // 达到单个连接的请求数上限，这个响应发完就关闭
+        if (++request_count >= max_requests)
+        {
+            keep_alive = false;
         }
-        // std::cout << "RecvHttpRequestLine: " << stop << std::endl; // 查看标记位的状态
-        return stop;
     }
 
-    // 接收请求报头
-    bool RecvHttpRequestHeader()
+    // 判断HTTP请求是否含有请求正文，为接收请求正文作准备
+    // Content-Length 超过 MAX_BODY_SIZE（或不是合法的数字）时不接收正文，回复 413，发送完关闭连接
+    bool IsNeedRecvHttpRequestBody()
     {
-        std::string line;
-        while (true)
+        auto &method = http_request.method;
+        if (method == "POST") // GET 和 POST 两种方法，只有 POST 方法含有请求正文
+        {
+            std::string_view length = http_request.GetHeader("Content-Length"); // 若有请求正文，则在请求报头中会提示Content-Length的大小
+            if (!length.empty())
+            {
+                // 找到了
+                long long value = -1;
+                auto ret = std::from_chars(length.data(), length.data() + length.size(), value);
+                if (ret.ec != std::errc() || value < 0 || value > MAX_BODY_SIZE)
+                {
+                    WARN("Content-Length %.*s too large", (int)length.size(), length.data());
+                    http_response.status_code = PAYLOAD_TOO_LARGE;
+                    keep_alive = false; // 正文没有读走，后面的数据不能再当作请求解析
+                    return false;
+                }
+                http_request.content_length = (int)value;
+                INFO("Post Method, Content-Length: %d", http_request.content_length); // 显示post方法对应的正文长度
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 接收请求正文，输入缓冲区中的部分已经取走，剩下的部分直接读进 http_request.request_body，不再经过输入缓冲区
+    // 正文收齐返回 true；数据还没到齐返回 false；出错时设置 stop
+    bool RecvHttpRequestBody()
+    {
+        auto &body = http_request.request_body;
+        size_t content_length = http_request.content_length;
+
+        while (body.size() < content_length)
         {
-            line.clear();
-            if (Utill::ReadLine(sock, line) <= 0)
+            size_t have = body.size();
+            body.resize(std::min(content_length, have + BODY_GROW_SIZE));
+            ssize_t s = recv(sock, &body[have], body.size() - have, 0);
+            body.resize(have + (s > 0 ? s : 0));
+            if (s > 0 || (s < 0 && errno == EINTR))
             {
-                stop = true; // 读取信息出错
-                break;
+                continue;
             }
+            if (s == 0 || !Utill::WouldBlock())
+            {
+                stop = true;
+            }
+            return false;
+        }
 
-            // 读到空行，代表请求报头读完了
-            if (line == "\n")
+        INFO("%s", body); // 提示接收到的正文内容
+        return true;
+    }
+
+    // 只用输入缓冲区中已有的数据推进请求的解析，不读套接字
+    // 解析出一个完整的请求返回 true，数据不够时停在当前阶段，返回 false
+    bool ParseHttpRequest()
+    {
+        if ((state == STATE_RECV_LINE || state == STATE_RECV_HEADER) && RecvHttpRequestHead())
+        {
+            CheckKeepAlive(); // 判断是否保持长连接
+            // 接收请求正文（仅POST方法）
+            state = IsNeedRecvHttpRequestBody() ? STATE_RECV_BODY : STATE_PROCESS;
+        }
+        if (state == STATE_RECV_BODY)
+        {
+            // 取走输入缓冲区中已经读到的正文
+            auto &body = http_request.request_body;
+            inbuffer.GetBytes(body, http_request.content_length - body.size());
+            if ((int)body.size() == http_request.content_length)
             {
-                http_request.blank = line;
-                break;
+                INFO("%s", body); // 提示接收到的正文内容
+                state = STATE_PROCESS;
             }
+        }
+        return state == STATE_PROCESS;
+    }
 
-            // 否则，读取的结果是请求报头
-            line.resize(line.size() - 1);
+    // 把构建好的响应放进输出队列：状态行、响应报头和空行合并成一段，CGI 正文直接移动进来，静态文件记录区间
+    // 状态行、响应报头、空行拼成一段内存数据，小文件的内容也读进这一段；CGI 正文单独一段（不拷贝）
+    // 同一个响应的这些数据段在发送时由一次 writev 写出，通常只占一个 TCP 报文段
+    void PushHttpResponse()
+    {
+        size_t head_size = http_response.status_line.size() + http_response.blank.size();
+        for (auto &iter : http_response.response_header)
+        {
+            head_size += iter.size();
+        }
+        bool small_file = !http_request.cgi && http_response.fd >= 0 && http_request.size <= SMALL_BODY_SIZE;
 
-            // 将读取的结果存入到请求报头中
-            http_request.request_header.push_back(line);
+        OutChunk head;
+        auto &data = head.data;
+        data.reserve(head_size + (small_file ? http_request.size : 0));
+        data += http_response.status_line;
+        for (auto &iter : http_response.response_header)
+        {
+            data += iter;
+        }
+        data += http_response.blank;
+        if (small_file && ReadSmallFile(data))
+        {
+            close(http_response.fd);
+            http_response.fd = -1;
+        }
+        outqueue.push_back(std::move(head));
 
-            // 打印请求报头的信息
-            INFO("%s", line);
+        if (http_request.cgi && http_response.pipe_fd >= 0) // 流式发送的 CGI 响应，正文从管道直接发送
+        {
+            OutChunk pipe;
+            pipe.fd = http_response.pipe_fd;
+            pipe.pipe = true;
+            pipe.chunked = http_response.chunked;
+            if (pipe.chunked)
+            {
+                CgiBufferPool::Get(pipe.data);
+            }
+            outqueue.push_back(std::move(pipe));
+        }
+        else if (http_request.cgi) // 为 CGI 响应，响应体已经通过 CGI 程序生成，保存在 http_response.response_body 中
+        {
+            if (!http_response.response_body.empty())
+            {
+                OutChunk body;
+                body.data.swap(http_response.response_body);
+                outqueue.push_back(std::move(body));
+            }
+        }
+        else if (http_response.fd >= 0) // 将文件的内容发送给客户端，文件描述符交给输出队列管理
+        {
+            OutChunk file;
+            file.fd = http_response.fd;
+            file.end = http_request.size;
+            outqueue.push_back(std::move(file));
+            http_response.fd = -1;
         }
-        // std::cout << "RecvHttpRequestHeader: " << stop << std::endl; // 查看标记位状态
-        return stop;
     }
 
-    // 解析请求行 = 方法 + uri + HTTP/版本（它们之间是采取空格分割）（⭐⭐⭐⭐⭐transform函数）
-    void ParseHttpRequestLine()
+    // 输出队列中是否有文件要发送（排在队头的内存数据之后）
+    bool FileFollows()
     {
-        // line引用字符串http_request.request_line
-        auto &line = http_request.request_line;
+        for (auto &chunk : outqueue)
+        {
+            if (chunk.fd >= 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
 
-        // 使用请求行字符串构造stringstream对象ss
-        std::stringstream ss(line);
+    // TCP_CORK：塞住时内核只发送满的报文段，拔掉时把剩下不满的报文段立即发出
+    void SetCork(bool on)
+    {
+        int opt = on ? 1 : 0;
+        setsockopt(sock, IPPROTO_TCP, TCP_CORK, &opt, sizeof(opt));
+        corked = on;
+    }
 
-        // 将其输出到 method uri version
-        ss >> http_request.method >> http_request.uri >> http_request.version;
+    // 把整个小文件追加到 data 后面；读取失败或文件被截断时恢复 data 并返回 false，交给 sendfile 处理
+    bool ReadSmallFile(std::string &data)
+    {
+        size_t head_size = data.size();
+        data.resize(head_size + http_request.size);
+        size_t done = 0;
+        while (done < (size_t)http_request.size)
+        {
+            ssize_t s = pread(http_response.fd, &data[head_size + done], http_request.size - done, done);
+            if (s > 0)
+            {
+                done += s;
+                continue;
+            }
+            if (s < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            data.resize(head_size);
+            return false;
+        }
+        return true;
+    }
 
-        auto &method = http_request.method; /// 对请求方法全部转换成大写（⭐⭐⭐⭐⭐transform函数）
-        std::transform(method.begin(), method.end(), method.begin(), ::toupper);
+    // 发送队头的文件：全部发送完返回 true
+    // 发送进度记录在 chunk.offset 中；发送缓冲区满了（EAGAIN）或用完本次的配额 quota 时返回 false，下一次可写时继续
+    bool SendFile(OutChunk &chunk, size_t &quota)
+    {
+        // 直接将文件从磁盘发送到客户端，而无需将文件内容读取到内存中。这可以减少 CPU 负担和内存拷贝的开销。
+        while (chunk.offset < chunk.end)
+        {
+            if (quota == 0)
+            {
+                return false;
+            }
+            size_t count = std::min((size_t)(chunk.end - chunk.offset), quota);
+            ssize_t s = sendfile(sock, chunk.fd, &chunk.offset, count);
+            if (s > 0)
+            {
+                quota -= s;
+                continue;
+            }
+            if (s < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (s == 0 || !Utill::WouldBlock())
+            {
+                stop = true; // 文件被截断或套接字出错
+            }
+            return false;
+        }
+        return true;
     }
 
-    // 解析请求报头，数据存入 unordered_map
-    void ParseHttpRequestHeader()
+    // 用一次 writev 发送队头连续的内存数据（可能跨多个响应）
+    // 这些数据全部发送完返回 true；只发送了一部分（发送缓冲区满了）或出错返回 false
+    bool SendChunks()
     {
-        std::string key;
-        std::string value;
-        // 由于请求报头是 key: value 格式，将其存入 unordered_map 里面
-        for (auto &iter : http_request.request_header)
+        struct iovec iov[MAX_IOV];
+        int cnt = 0;
+        size_t total = 0;
+        size_t offset = out_offset;
+        for (auto iter = outqueue.begin(); iter != outqueue.end() && iter->fd < 0 && cnt < MAX_IOV; ++iter)
         {
-            if (Utill::CutString(iter, key, value, SEP)) // 分隔符是 “: ”
+            iov[cnt].iov_base = (char *)iter->data.c_str() + offset;
+            iov[cnt].iov_len = iter->data.size() - offset;
+            total += iov[cnt].iov_len;
+            offset = 0;
+            cnt++;
+        }
+
+        ssize_t s = writev(sock, iov, cnt);
+        if (s < 0)
+        {
+            if (errno != EINTR && !Utill::WouldBlock())
             {
-                http_request.header_kv.insert({key, value});
+                stop = true; // 对端关闭或出错
             }
+            return errno == EINTR;
         }
+
+        // 弹出已经发送完的数据段
+        size_t n = s + out_offset;
+        while (!outqueue.empty() && outqueue.front().fd < 0 && n >= outqueue.front().data.size())
+        {
+            n -= outqueue.front().data.size();
+            CgiBufferPool::Put(outqueue.front().data); // CGI 正文的缓冲区留给下一个 CGI 请求
+            outqueue.pop_front();
+        }
+        out_offset = n;
+        return (size_t)s == total;
     }
 
-    // 判断HTTP请求是否含有请求正文，为接收请求正文作准备
-    bool IsNeedRecvHttpRequestBody()
+    // 用 splice 把 CGI 的输出从管道直接移到套接字，数据不经过用户空间，直到子进程关闭标准输出
+    // 发送到文件结束返回 true；发送缓冲区满了、配额用完、管道暂时没有数据（设置 cgi_wait）或出错返回 false
+    bool SendPipe(OutChunk &chunk, size_t &quota)
     {
-        auto &method = http_request.method;
-        if (method == "POST") // GET 和 POST 两种方法，只有 POST 方法含有请求正文
+        while (quota > 0)
         {
-            auto &header_kv = http_request.header_kv;
-            auto iter = header_kv.find("Content-Length"); // 若有请求正文，则在请求报头中会提示Content-Length的大小
-            if (iter != header_kv.end())
+            ssize_t s = splice(chunk.fd, nullptr, sock, nullptr, quota, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE);
+            if (s > 0)
             {
-                // 找到了
-                INFO("%s", "Post Method, Content-Length: " + iter->second); // 显示post方法对应的正文长度
-                http_request.content_length = atoi(iter->second.c_str());
+                quota -= s;
+                continue;
+            }
+            if (s == 0)
+            {
+                cgi.CloseStdout();
                 return true;
             }
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (!Utill::WouldBlock())
+            {
+                stop = true; // 对端关闭或出错
+                return false;
+            }
+            // 管道和套接字任何一边没准备好都是 EAGAIN：管道里没有数据就等子进程，否则等套接字可写
+            int pending = 0;
+            if (ioctl(chunk.fd, FIONREAD, &pending) == 0 && pending == 0)
+            {
+                cgi_wait = true;
+                if (corked)
+                    SetCork(false); // 等待期间先把已经 splice 的数据发出去
+            }
+            return false;
         }
         return false;
     }
 
-    // 接收请求正文，将正文存入 http_request.request_body
-    bool RecvHttpRequestBody()
+    // 分块发送 CGI 的输出：从管道读一块（不超过 STREAM_BUFFER_SIZE），加上块头块尾放在 chunk.data 中，发送完再读下一块
+    // 套接字发不动时不再读管道，子进程写满管道后阻塞，每个请求占用的内存不超过一块
+    // 管道读到文件结束后等子进程退出：正常退出才发送结束块，否则关闭连接，客户端收到的是不完整的分块正文
+    // 结束块发送完返回 true；发送缓冲区满了、配额用完、管道暂时没有数据（设置 cgi_wait）、
+    // 等子进程退出（设置 cgi_exit_wait）或出错返回 false
+    bool SendStream(OutChunk &chunk, size_t &quota)
     {
-        // 只有 POST 方法才需要进行接收
-        if (IsNeedRecvHttpRequestBody())
+        auto &data = chunk.data;
+        while (true)
         {
-            int content_length = http_request.content_length;
-            auto &body = http_request.request_body;
-
-            char ch = 0;
-            while (content_length)
+            if (chunk.offset < (off_t)data.size())
             {
-                ssize_t s = recv(sock, &ch, 1, 0);
+                if (quota == 0)
+                    return false;
+                ssize_t s = send(sock, data.data() + chunk.offset, data.size() - chunk.offset, 0);
                 if (s > 0)
                 {
-                    body.push_back(ch);
-                    content_length--;
+                    chunk.offset += s;
+                    quota -= std::min((size_t)s, quota);
+                    continue;
                 }
-                else
+                if (s < 0 && errno == EINTR)
+                    continue;
+                if (s < 0 && !Utill::WouldBlock())
+                    stop = true; // 对端关闭或出错
+                return false;
+            }
+            if (chunk.end)
+            {
+                return true;
+            }
+            if (chunk.fd >= 0)
+            {
+                // 块头右对齐写在预留的空间里，数据不用移动
+                data.resize(CHUNK_HEAD_SIZE + STREAM_BUFFER_SIZE);
+                ssize_t s = read(chunk.fd, &data[CHUNK_HEAD_SIZE], STREAM_BUFFER_SIZE);
+                if (s > 0)
+                {
+                    char head[CHUNK_HEAD_SIZE + 1];
+                    int n = snprintf(head, sizeof(head), "%zx" LINE_END, (size_t)s);
+                    memcpy(&data[CHUNK_HEAD_SIZE - n], head, n);
+                    data.resize(CHUNK_HEAD_SIZE + s);
+                    data += LINE_END;
+                    chunk.offset = CHUNK_HEAD_SIZE - n;
+                    continue;
+                }
+                data.clear();
+                chunk.offset = 0;
+                if (s < 0 && errno == EINTR)
+                    continue;
+                if (s < 0 && Utill::WouldBlock())
                 {
-                    stop = true;
-                    break;
+                    cgi_wait = true;
+                    if (corked)
+                        SetCork(false); // 等待期间先把已经写入的数据发出去
+                    return false;
                 }
+                cgi.CloseStdout(); // 子进程关闭了标准输出
+                chunk.fd = -1;
+            }
+            if (cgi.State() != CGI_DONE)
+            {
+                cgi_exit_wait = true;
+                if (corked)
+                    SetCork(false);
+                return false;
+            }
+            if (cgi.Code() != OK)
+            {
+                WARN("cgi exit with %d after streaming, abort response", cgi.Code());
+                stop = true;
+                return false;
             }
+            data = LAST_CHUNK;
+            chunk.end = 1;
+        }
+    }
+
+    // 服务器计数器，和 CGI 一样把正文放在 http_response.response_body 中
+    int ProcessStatus()
+    {
+        http_request.cgi = true;
+        http_request.suffix = ".txt";
+        http_response.response_body = ServerStats::getinstance()->Format();
+        return OK;
+    }
+
+    // 传递给 CGI 程序的环境变量，在父进程中准备好
+    std::vector<std::string> CgiVars()
+    {
+        auto &method = http_request.method;
+        std::vector<std::string> vars;
+        vars.push_back("METHOD=" + std::string(method));
+        if (method == "GET")
+        {
+            vars.push_back("QUERY_STRING=" + std::string(http_request.query_string));
+            INFO("%s", "Get Method, Add Query_String Env");
+        }
+        else if (method == "POST")
+        {
+            vars.push_back("CONTENT_LENGTH=" + std::to_string(http_request.content_length));
+            INFO("%s", "Post Method, Add Content_Length Env");
+        }
+        return vars;
+    }
 
-            INFO("%s", body); // 提示接收到的正文内容
+    // 由 reactor 驱动执行 CGI 程序：启动子进程并注册到 reactor，返回 true 之后不能再访问这个连接
+    // （CGI_OUTPUT_SPLICE 时例外：子进程启动后立即构建响应，正文由输出队列从管道直接发送）
+    // 返回 false：启动失败（cgi 的状态为 CGI_DONE，带着要回复的状态码），或者内核不支持 pidfd（状态仍为 CGI_IDLE）
+    bool StartCgi()
+    {
+        if (!CgiProcess::Supported())
+        {
+            return false;
         }
-        return stop;
+        INFO("start cgi: %s", http_request.path.c_str());
+        return cgi.Start(http_request.path, Spawn::BuildEnv(CgiVars()), http_request.request_body, cgi_output);
     }
 
-    // 处理CGI机制
+    // 处理CGI机制：阻塞等待子进程，只在内核不支持 pidfd 或者 FastCGI 后端不可用时使用
     int ProcessCgi()
     {
         INFO("%s", "process cgi mthod!");
@@ -258,78 +775,42 @@ private:
         int code = OK;
         // 父进程数据
         auto &method = http_request.method;
-        auto &query_string = http_request.query_string;   // GET方法请求资源的内容
         auto &body_text = http_request.request_body;      // POST方法请求资源的内容
         auto &bin = http_request.path;                    // 保持子进程执行的目标程序，一定存在
         int content_length = http_request.content_length; // 请求正文长度post
 
         auto &response_body = http_response.response_body; // 响应正文
+        std::vector<std::string> vars = CgiVars();
 
-        // 设置环境变量，用来传递给子进程
-        std::string query_string_env;   // GET方法请求资源的内容
-        std::string method_env;         // 请求方法
-        std::string content_length_env; // post请求正文长度
-
-        // 站在父进程角度，创建输入输出管道
+        // 站在父进程角度，创建输入输出管道；O_CLOEXEC：别的线程同时启动的子进程不会继承这里的管道
         int input[2];  // 0代表读，1代表写；父进程向input读取内容，接收子进程的输入
         int output[2]; // 0代表读，1代表写；父进程向output写入内容，输出给子进程
-        if (pipe(input) < 0)
+        if (pipe2(input, O_CLOEXEC) < 0)
         {
             ERROR("%s", "pipe input error");
             code = SERVER_ERROR;
             return code;
         }
-        if (pipe(output) < 0)
+        if (pipe2(output, O_CLOEXEC) < 0)
         {
             ERROR("%s", "pipe output error");
+            close(input[0]);
+            close(input[1]);
             code = SERVER_ERROR;
             return code;
         }
 
-        // 新线程，但是从头到尾都只有一个进程，就是httpserver！
-        pid_t pid = fork();
-        if (pid == 0) // child
-        {
-            close(input[0]);  // 子进程要向该管道输入数据
-            close(output[1]); // 子进程要向该管道读取数据
-
-            method_env = "METHOD=";
-            method_env += method;
-
-            putenv((char *)method_env.c_str());
-
-            // 子进程获取当前请求方法
-            if (method == "GET")
-            {
-                query_string_env = "QUERY_STRING=";
-                query_string_env += query_string;
-                putenv((char *)query_string_env.c_str());
-                INFO("%s", "Get Method, Add Query_String Env");
-            }
-            else if (method == "POST")
-            {
-                content_length_env = "CONTENT_LENGTH=";
-                content_length_env += std::to_string(content_length);
-                putenv((char *)content_length_env.c_str());
-                INFO("%s", "Post Method, Add Content_Length Env");
-            }
-            else
-            {
-                // Do Nothing
-            }
-
-            std::cout << "bin: " << bin << std::endl;
-
-            // 重定向
-            dup2(output[0], 0); // 子进程向该管道0号文件输入数据--重定向到标准输出
-            dup2(input[1], 1);  // 子进程向该管道1号文件写入数据--重定向到标准写入
-            // 进程替换
-            execl(bin.c_str(), bin.c_str(), nullptr);
-            exit(1);
-        }
-        else if (pid < 0) // error
+        // 子进程的标准输入是 output 的读端、标准输出是 input 的写端，其余描述符（客户端连接、缓存的文件）都不继承
+        // 不 fork：子进程和服务器共享地址空间，直接 exec（见 Spawn）
+        INFO("bin: %s", bin.c_str());
+        pid_t pid = Spawn::Run(bin.c_str(), Spawn::BuildEnv(vars), output[0], input[1]);
+        if (pid < 0) // error
         {
-            ERROR("%s", "fork error!");
+            ERROR("spawn %s error: %s", bin.c_str(), strerror(errno));
+            close(input[0]);
+            close(input[1]);
+            close(output[0]);
+            close(output[1]);
             return 404;
         }
         else // parent
@@ -337,6 +818,8 @@ private:
             close(input[1]);  // 父进程向该管道0号文件输入数据
             close(output[0]); // 父进程向该管道1号文件写入数据
 
+            BlockingScope blocking(ServerStats::getinstance()->Pool(POOL_CGI)); // 下面一直在等子进程，线程池据此增加线程
+
             if (method == "POST")
             {
                 const char *start = body_text.c_str();
@@ -347,10 +830,9 @@ private:
                     total += size;
                 }
             }
-            char ch = 0;
-            while (read(input[0], &ch, 1) > 0) // 读取子进程的输入，放入响应正文中
+            ssize_t s = 0; // 读取子进程的输出，整块放入响应正文中
+            while ((s = CgiBufferPool::ReadAppend(input[0], response_body)) > 0 || (s < 0 && errno == EINTR))
             {
-                response_body.push_back(ch);
             }
             int status = 0;                       // 保存子进程的退出状态
             pid_t ret = waitpid(pid, &status, 0); // 父进程调用 waitpid() 等待子进程 pid 结束，并获取其退出状态
@@ -375,6 +857,169 @@ private:
         return code;
     }
 
+    // 把请求交给 FastCGI 后端：参数按 CGI/1.1 的环境变量传递（另外带上本仓库 CGI 程序使用的 METHOD），
+    // 正文作为 FCGI_STDIN 发送，程序的输出（CGI 格式）解析成响应
+    // 连不上后端时，本地有同名的可执行程序就退回到直接执行它
+    // 输出总是收完整（FCGI_END_REQUEST）之后再按 Content-Length 发送，不受 cgi_output 影响：FastCGI 没有按请求的流量控制，
+    // 一个连接上多路复用的请求由同一个线程读取，边收边发给慢的客户端会让同一连接上的其他请求跟着等，要么还是得把输出存下来
+    int ProcessFastCgi()
+    {
+        INFO("%s", "process fastcgi method!");
+        ServerStats *stats = ServerStats::getinstance();
+        stats->fcgi_requests++;
+
+        FastCgiParams params;
+        params.Add("GATEWAY_INTERFACE", "CGI/1.1");
+        params.Add("SERVER_SOFTWARE", "httpserver");
+        params.Add("SERVER_PROTOCOL", http_request.version);
+        params.Add("REQUEST_METHOD", http_request.method);
+        params.Add("METHOD", http_request.method);
+        params.Add("REQUEST_URI", http_request.uri);
+        params.Add("SCRIPT_NAME", http_request.script_name);
+        params.Add("PATH_INFO", http_request.path_info);
+        params.Add("SCRIPT_FILENAME", http_request.path);
+        params.Add("DOCUMENT_ROOT", WEB_ROOT);
+        params.Add("QUERY_STRING", http_request.query_string);
+        if (http_request.method == "POST")
+        {
+            params.Add("CONTENT_LENGTH", std::to_string(http_request.content_length));
+        }
+        struct sockaddr_storage peer;
+        socklen_t len = sizeof(peer);
+        char host[NI_MAXHOST], port[NI_MAXSERV];
+        if (getpeername(sock, (struct sockaddr *)&peer, &len) == 0 &&
+            getnameinfo((struct sockaddr *)&peer, len, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+        {
+            params.Add("REMOTE_ADDR", host);
+            params.Add("REMOTE_PORT", port);
+        }
+        // 请求报头：Content-Type 和 Content-Length 不加前缀，其余的转换成 HTTP_大写名字
+        std::string name;
+        for (auto &header : http_request.header_kv)
+        {
+            if (header.name.size() == 14 && strncasecmp(header.name.data(), "Content-Length", 14) == 0)
+            {
+                continue;
+            }
+            bool content_type = header.name.size() == 12 && strncasecmp(header.name.data(), "Content-Type", 12) == 0;
+            name = content_type ? "" : "HTTP_";
+            for (char c : header.name)
+            {
+                name.push_back(c == '-' ? '_' : toupper((unsigned char)c));
+            }
+            params.Add(name, header.value);
+        }
+
+        FastCgiResult result;
+        int ret;
+        {
+            BlockingScope blocking(stats->Pool(POOL_CGI)); // 等后端的结果，和等 CGI 子进程一样
+            ret = fcgi->Request(params, http_request.request_body, result);
+        }
+        if (!result.err.empty())
+        {
+            WARN("fastcgi stderr: %s", result.err.c_str());
+        }
+        if (ret == FCGI_UNAVAILABLE)
+        {
+            struct stat st;
+            if (stat(http_request.path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && (st.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH)))
+            {
+                stats->fcgi_fallbacks++;
+                return ProcessCgi();
+            }
+        }
+        if (ret != FCGI_OK)
+        {
+            stats->fcgi_failed++;
+            return BAD_GATEWAY;
+        }
+        return ParseCgiOutput(result.out);
+    }
+
+    // 解析 CGI 格式的输出：报头（Status、Content-Type、Location 和其他要转发的报头），空行，正文
+    // 没有报头的输出整个作为正文
+    int ParseCgiOutput(std::string &out)
+    {
+        int code = OK;
+        size_t end = out.find("\n\n");
+        size_t crlf = out.find("\r\n\r\n");
+        size_t body = std::string::npos;
+        if (crlf != std::string::npos && (end == std::string::npos || crlf < end))
+        {
+            end = crlf;
+            body = crlf + 4;
+        }
+        else if (end != std::string::npos)
+        {
+            body = end + 2;
+        }
+        http_response.from_app = true;
+        if (body == std::string::npos)
+        {
+            http_response.response_body.swap(out);
+            return code;
+        }
+        bool has_status = false;
+        bool has_location = false;
+        std::string_view head(out.data(), end);
+        while (!head.empty())
+        {
+            size_t eol = head.find('\n');
+            std::string_view line = head.substr(0, eol);
+            head = eol == std::string_view::npos ? std::string_view() : head.substr(eol + 1);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos)
+            {
+                continue;
+            }
+            std::string_view name = line.substr(0, colon);
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && value.front() == ' ')
+            {
+                value.remove_prefix(1);
+            }
+            auto is = [&](const char *s) { return name.size() == strlen(s) && strncasecmp(name.data(), s, name.size()) == 0; };
+            if (is("Status"))
+            {
+                std::from_chars(value.data(), value.data() + value.size(), code);
+                size_t space = value.find(' ');
+                if (space != std::string_view::npos)
+                {
+                    http_response.reason = value.substr(space + 1);
+                }
+                has_status = true;
+            }
+            else if (is("Content-Type"))
+            {
+                http_response.content_type = value;
+            }
+            else if (is("Content-Length") || is("Connection") || is("Transfer-Encoding") || is("Keep-Alive"))
+            {
+                // 由服务器自己决定
+            }
+            else
+            {
+                has_location = has_location || is("Location");
+                std::string header(line);
+                header += LINE_END;
+                http_response.response_header.push_back(header);
+            }
+        }
+        if (has_location && !has_status)
+        {
+            code = 302;
+            http_response.reason = "Found";
+        }
+        out.erase(0, body);
+        http_response.response_body.swap(out);
+        return code;
+    }
+
     // 非CGI机制返回信息
     int ProcessNonCgi()
     {
@@ -392,11 +1037,26 @@ private:
     {
         // 构建HTTP的响应报头（Content-Type）
         std::string line = "Content-Type: ";
-        line += Suffix2Desc(http_request.suffix);
+        if (http_response.content_type.empty())
+        {
+            line += Suffix2Desc(http_request.suffix);
+        }
+        else
+        {
+            line += http_response.content_type;
+        }
         line += LINE_END;
         http_response.response_header.push_back(line);
 
         // 构建HTTP的响应报头（Content-Length）
+        if (http_response.pipe_fd >= 0) // 流式发送的 CGI 输出，长度未知：分块编码，或者以关闭连接表示正文结束
+        {
+            if (http_response.chunked)
+            {
+                http_response.response_header.push_back("Transfer-Encoding: chunked" LINE_END);
+            }
+            return;
+        }
         line = "Content-Length: ";
         if (http_request.cgi) // CGI机制
         {
@@ -432,6 +1092,10 @@ private:
             line += LINE_END;
             http_response.response_header.push_back(line);
         }
+        else
+        {
+            keep_alive = false; // 没有 Content-Length，只能通过关闭连接告诉对方正文结束
+        }
     }
 
     // 辅助函数构建HTTP响应（状态行（HTTP版本 + 状态码 + 状态码描述） + 响应报头 + 空行 + 响应正文）
@@ -444,13 +1108,13 @@ private:
         status_line += " ";                            // 状态行不同信息之间的分隔符是空格
         status_line += std::to_string(code);           // 其次，添加状态码
         status_line += " ";                            // 状态行不同信息之间的分隔符是空格
-        status_line += Code2Desc(code);                // 最后，添加状态码描述
+        status_line += http_response.reason.empty() ? Code2Desc(code) : http_response.reason; // 最后，添加状态码描述
         status_line += LINE_END;                       // 状态行构建结束
 
         // 构建响应正文，可能包括响应报头
         std::string path = WEB_ROOT;
         path += "/";
-        switch (code)
+        switch (http_response.from_app ? OK : code) // FastCGI 程序给出的响应不论状态码都原样转发
         {
         case OK:
             BuildOkResponse();
@@ -460,20 +1124,34 @@ private:
             HandlerError(path);
             break;
         case BAD_REQUEST:
+        case PAYLOAD_TOO_LARGE:
             path += PAGE_404;
             HandlerError(path);
             break;
         case SERVER_ERROR:
+        case BAD_GATEWAY:
             path += PAGE_404;
             HandlerError(path);
             break;
         default:
             break;
         }
+
+        // 告诉对方这个响应之后是否保持连接
+        http_response.response_header.push_back(keep_alive ? "Connection: keep-alive" LINE_END : "Connection: close" LINE_END);
+    }
+
+    // 重新设置套接字关心的事件（事件是一次性的：每次事件就绪后都需要重新设置）
+    void ModEvent(uint32_t events)
+    {
+        poller->Mod(sock, events, this);
     }
 
 public:
-    EndPoint(int _sock) : sock(_sock), stop(false)
+    EndPoint(int _sock, Poller *_poller, int _max_requests, unsigned _home = 0, int _cgi_output = CGI_OUTPUT_BUFFER, bool _status_page = false)
+        : sock(_sock), poller(_poller), stop(false), state(STATE_RECV_LINE),
+          keep_alive(false), request_count(0), max_requests(_max_requests), home(_home), timer(this), timer_phase(PHASE_NONE), route(ROUTE_NONE), fcgi(nullptr), cgi(this, _poller),
+          out_offset(0), sending(false), close_after_send(false), corked(false), cgi_output(_cgi_output), status_page(_status_page), cgi_wait(false), cgi_exit_wait(false)
     {
     }
 
@@ -482,25 +1160,297 @@ public:
         return stop;
     }
 
-    // 接收HTTP请求信息
-    void RecvHttpRequest()
+    int Sock()
+    {
+        return sock;
+    }
+
+    bool IsSending()
+    {
+        return sending;
+    }
+
+    bool CloseAfterSend()
+    {
+        return close_after_send;
+    }
+
+    unsigned Home()
+    {
+        return home;
+    }
+
+    TimerNode *Timer()
+    {
+        return &timer;
+    }
+
+    TimeoutPhase TimerPhase()
+    {
+        return timer_phase;
+    }
+
+    void SetTimerPhase(TimeoutPhase phase)
+    {
+        timer_phase = phase;
+    }
+
+    // 连接当前所处的等待阶段
+    TimeoutPhase Phase()
+    {
+        if (sending)
+        {
+            return PHASE_SEND;
+        }
+        switch (state)
+        {
+        case STATE_RECV_LINE:
+            return request_count > 0 && inbuffer.ReadableSize() == 0 ? PHASE_IDLE : PHASE_REQUEST_LINE;
+        case STATE_RECV_HEADER:
+            return PHASE_HEADER;
+        case STATE_RECV_BODY:
+            return PHASE_BODY;
+        default:
+            return PHASE_NONE;
+        }
+    }
+
+    // 长连接：当前请求的响应已放入输出队列，准备解析下一个请求；输入缓冲区和输出队列都保留
+    void Reset()
+    {
+        http_request.Reset();
+        http_response.Reset();
+        state = STATE_RECV_LINE;
+        keep_alive = false;
+        route = ROUTE_NONE;
+        fcgi = nullptr;
+        cgi.Reset();
+    }
+
+    bool WaitingCgiOutput()
+    {
+        return cgi_wait;
+    }
+
+    bool WaitingCgiExit()
+    {
+        return cgi_exit_wait;
+    }
+
+    // 当前请求是流式发送的 CGI 请求，响应头已经放进了输出队列
+    bool CgiStreamed()
+    {
+        return route == ROUTE_CGI && http_response.pipe_fd >= 0;
+    }
+
+    // CGI_OUTPUT_STREAM：子进程第一次有输出（reactor 收到 CGI_EVENT_OUTPUT），构建响应头放进输出队列，正文跟在后面边读边发
+    // HTTP/1.1 用分块编码，可以保持连接；HTTP/1.0 以关闭连接表示正文结束，用 splice 发送
+    // 子进程没有任何输出就关闭了标准输出时返回 false：等它退出后和 CGI_OUTPUT_BUFFER 一样按退出状态构建响应
+    bool BeginCgiStream()
+    {
+        int pending = 0;
+        if (ioctl(cgi.StdoutFd(), FIONREAD, &pending) == 0 && pending == 0)
+        {
+            cgi.CloseStdout();
+            return false;
+        }
+        http_response.status_code = OK;
+        http_response.pipe_fd = cgi.StdoutFd();
+        http_response.chunked = http_request.version == "HTTP/1.1";
+        if (!http_response.chunked)
+        {
+            keep_alive = false;
+        }
+        else
+        {
+            // 结束块只有几个字节，前面的块还没确认时会被 Nagle 算法扣住，等客户端的延迟确认（约 40ms）
+            // 响应头和数据的合并由 TCP_CORK 负责，等待子进程时拔掉塞子立即发出
+            int opt = 1;
+            setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+        }
+        BuildHttpResponseHelper();
+        PushHttpResponse();
+        if (!keep_alive)
+        {
+            close_after_send = true;
+        }
+        sending = true;
+        return true;
+    }
+
+    // 输出队列停在 CGI 管道上：等子进程输出（之后 reactor 收到 CGI_EVENT_OUTPUT 再继续发送）
+    void EnableCgiOutput()
     {
-        // 短路求值（接收请求行和请求报头，如果没有这两个，则无需进行解析）
-        if ((!RecvHttpRequestLine()) && (!RecvHttpRequestHeader()))
+        cgi.WatchStdout();
+    }
+
+    // CGI 子进程启动的时间（单调时钟的毫秒数）
+    uint64_t CgiStartMs()
+    {
+        return cgi.StartMs();
+    }
+
+    // 子进程执行期间连接由 reactor 持有；CGI_OUTPUT_SPLICE 启动子进程后工作线程还要构建响应，之后才交给 reactor
+    bool CgiHeldByReactor()
+    {
+        return cgi_output != CGI_OUTPUT_SPLICE;
+    }
+
+    // 连接关闭时 CGI 子进程还在执行（流式发送或 CGI 执行超时）：返回 true 表示要等子进程结束之后才能释放连接
+    bool AbandonCgi()
+    {
+        return cgi.Abandon();
+    }
+
+    // CGI 线程池的队列满了，但子进程已经执行完：不能回复 503（请求的副作用已经发生），
+    // 输出就在 cgi 中，构建响应不需要阻塞，由 reactor 线程直接构建；流水线上后面的请求等这个响应发送完后由 reactor 重新读取
+    void BuildCgiResponse()
+    {
+        BuildHttpResponse();
+        PushHttpResponse();
+        if (!keep_alive)
+        {
+            close_after_send = true;
+        }
+        else
+        {
+            Reset();
+        }
+        sending = true;
+    }
+
+    // 过载：不处理这个请求，直接在输出队列后面追加预先拼好的 503 响应，发送完关闭连接
+    // 流水线上已经构建好的响应排在前面，仍然按顺序发送
+    void PushServiceUnavailable()
+    {
+        OutChunk chunk;
+        chunk.data = SERVICE_UNAVAILABLE_RESPONSE;
+        outqueue.push_back(std::move(chunk));
+        close_after_send = true;
+        sending = true;
+    }
+
+    // 继续等待请求数据
+    void EnableRead()
+    {
+        sending = false;
+        ModEvent(EPOLLIN);
+    }
+
+    // 响应已构建完毕（或还没发送完），等待套接字可写
+    void EnableWrite()
+    {
+        sending = true;
+        ModEvent(EPOLLOUT);
+    }
+
+    // 接收HTTP请求信息：套接字可读时由 reactor 调用，从上次停下的阶段继续
+    // 请求行和请求报头从输入缓冲区中解析，缓冲区里的数据不够时才读套接字
+    // 返回 true 表示完整的请求已经读完；返回 false 且 stop 为 false 表示数据还没到齐
+    bool RecvHttpRequest()
+    {
+        while (!stop)
+        {
+            if (ParseHttpRequest())
+            {
+                return true;
+            }
+            if (state == STATE_RECV_BODY)
+            {
+                if (!RecvHttpRequestBody())
+                    return false;
+                state = STATE_PROCESS;
+                return true;
+            }
+            // 缓冲区中的数据不够，从套接字再读一批
+            if (!RecvToBuffer())
+            {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // 处理已经读完整的请求：构建响应放进输出队列
+    // 客户端使用流水线时，输入缓冲区里可能已经有了后面的请求，按顺序接着处理，响应最后一起发送
+    // cls：调用者所在的线程池；静态线程池遇到 CGI 请求时返回 HANDLE_HANDOFF，由调用者交给 CGI 线程池从这个请求接着处理，
+    // 前面已经构建的响应留在输出队列里，最后一起发送
+    // CGI 线程池启动子进程后返回 HANDLE_PENDING，不等它结束；子进程结束后 reactor 再把连接交给 CGI 线程池，
+    // 从这个请求接着处理（这时 cgi 的状态为 CGI_DONE）
+    HandleResult HandlerHttpRequests(int cls)
+    {
+        while (true)
         {
-            ParseHttpRequestLine();   // 解析请求行
-            ParseHttpRequestHeader(); // 解析请求报头
-            RecvHttpRequestBody();    // 接收请求正文（仅POST方法）
+            if (route == ROUTE_NONE)
+            {
+                ResolveHttpRequest();
+            }
+            if ((route == ROUTE_CGI || route == ROUTE_FASTCGI) && cls != POOL_CGI)
+            {
+                return HANDLE_HANDOFF;
+            }
+            if (route == ROUTE_CGI && cgi.State() == CGI_IDLE && StartCgi() && cgi_output != CGI_OUTPUT_SPLICE)
+            {
+                return HANDLE_PENDING;
+            }
+            BuildHttpResponse();
+            PushHttpResponse();
+            if (!keep_alive)
+            {
+                close_after_send = true; // 这个响应之后的请求都不再处理
+                return HANDLE_DONE;
+            }
+            Reset();
+            if (!ParseHttpRequest())
+            {
+                return HANDLE_DONE; // 下一个请求还不完整，交给 reactor 继续读取
+            }
         }
     }
 
     // 依据接收到的HTTP请求信息构建HTTP响应
     void BuildHttpResponse()
+    {
+        if (route == ROUTE_CGI && cgi.State() == CGI_RUNNING) // CGI_OUTPUT_SPLICE：子进程刚启动，正文从管道直接发送
+        {
+            http_response.status_code = OK;
+            http_response.pipe_fd = cgi.StdoutFd();
+            keep_alive = false; // 没有 Content-Length，以关闭连接表示正文结束
+        }
+        else if (route == ROUTE_CGI && cgi.State() == CGI_DONE)
+        {
+            http_response.status_code = cgi.Code(); // 子进程已经由 reactor 执行完了
+            cgi.TakeOutput(http_response.response_body);
+        }
+        else if (route == ROUTE_CGI)
+        {
+            http_response.status_code = ProcessCgi(); // 拿到结果:http_response.response_body;
+        }
+        else if (route == ROUTE_FASTCGI)
+        {
+            http_response.status_code = ProcessFastCgi();
+        }
+        else if (route == ROUTE_STATIC)
+        {
+            // 1. 目标网页一定是存在的
+            // 2. 返回并不是单单返回网页，而是要构建HTTP响应
+            http_response.status_code = ProcessNonCgi(); // 简单的网页返回，返回静态网页，只需要打开即可
+        }
+        BuildHttpResponseHelper();
+    }
+
+    // 解析请求的资源路径，决定请求的去向（route）：错误和状态页直接得到结果，其余的是静态文件或者 CGI
+    void ResolveHttpRequest()
     {
         auto &code = http_response.status_code;
-        std::string _path;
+        std::string_view _path;
         struct stat st;
-        std::size_t found = 0;
+        const char *dot = nullptr;
+
+        if (code == PAYLOAD_TOO_LARGE) // 接收请求头时就已经拒绝了
+        {
+            goto END;
+        }
 
         // 强制要求接收到的请求的方法必须是GET和POST
         if (http_request.method != "GET" && http_request.method != "POST")
@@ -512,26 +1462,35 @@ public:
             goto END;
         }
 
+        if (status_page && http_request.method == "GET" && http_request.uri == STATUS_URI)
+        {
+            code = ProcessStatus();
+            goto END;
+        }
+
         // 以下是请求方法为GET的处理流程
         if (http_request.method == "GET")
         {
             // GET方法可以带参数也可以不带，若带则是通过URI传参（URI = /a/b?1+1）
-            size_t pos = http_request.uri.find('?'); // 判断是否带参数，（路径?交互信息）
-            if (pos != std::string::npos)
+            std::string_view uri = http_request.uri;
+            const char *mark = Scan::FindChar(uri.data(), uri.data() + uri.size(), '?'); // 判断是否带参数，（路径?交互信息）
+            if (mark != uri.data() + uri.size())
             {
-                Utill::CutString(http_request.uri, http_request.path, http_request.query_string, "?");
+                size_t pos = mark - uri.data();
+                _path = http_request.uri.substr(0, pos);
+                http_request.query_string = http_request.uri.substr(pos + 1);
                 http_request.cgi = true; // 带有参数则为CGI机制
             }
             else
             {
-                http_request.path = http_request.uri; // 没有找到?则说明URI就是一段路径
+                _path = http_request.uri; // 没有找到?则说明URI就是一段路径
             }
         }
         // 以下是请求方法为POST的处理流程
         else if (http_request.method == "POST")
         {
             http_request.cgi = true;
-            http_request.path = http_request.uri;
+            _path = http_request.uri;
         }
         // 可拓展其他请求方法
         else
@@ -539,9 +1498,20 @@ public:
             // Do Nothing===为了拓展其他方法
         }
 
+        // 配置了 FastCGI 后端的路径交给常驻的 FastCGI 进程，本地不需要有对应的文件
+        fcgi = FastCgi::getinstance()->Match(_path, http_request.script_name, http_request.path_info);
+        if (fcgi != nullptr)
+        {
+            http_request.cgi = true;
+            http_request.path = WEB_ROOT;
+            http_request.path += http_request.script_name;
+            http_request.suffix = ".html"; // 程序没有给出 Content-Type 时使用
+            route = ROUTE_FASTCGI;
+            return;
+        }
+
         // 重新构建HTTP请求的资源路径，从WEB根目录下开始
-        _path = http_request.path;    // 先保存从请求行中获取到的路径
-        http_request.path = WEB_ROOT; // 重新设定HTTP请求的资源路径的开始
+        http_request.path = WEB_ROOT; // HTTP请求的资源路径的开始
         http_request.path += _path;   // 加上从请求行中获取到的路径
 
         // 请求的路径对应资源是一个目录
@@ -581,68 +1551,78 @@ public:
         }
 
         // 查找请求资源的后缀名
-        found = http_request.path.rfind(".");
-        if (found == std::string::npos)
+        dot = Scan::FindLastChar(http_request.path.data(), http_request.path.data() + http_request.path.size(), '.');
+        if (dot == http_request.path.data() + http_request.path.size())
         {
             http_request.suffix = ".html"; // 默认后缀是 .html
         }
         else
         {
-            http_request.suffix = http_request.path.substr(found); // 截取后缀
+            http_request.suffix = std::string_view(http_request.path).substr(dot - http_request.path.data()); // 截取后缀
         }
 
-        // 判断是否是CGI机制
-        if (http_request.cgi) // 是，执行目标程序
-        {
-            code = ProcessCgi(); // 拿到结果:http_response.response_body;
-        }
-        else // 不是，构建HTTP响应，返回静态网页
-        {
-            // 1. 目标网页一定是存在的
-            // 2. 返回并不是单单返回网页，而是要构建HTTP响应
-            code = ProcessNonCgi(); // 简单的网页返回，返回静态网页，只需要打开即可
-        }
+        // 判断是否是CGI机制：是，执行目标程序；不是，返回静态网页
+        route = http_request.cgi ? ROUTE_CGI : ROUTE_STATIC;
+        return;
 
     END:
-        BuildHttpResponseHelper();
+        route = ROUTE_DONE;
     }
 
-    // 发送
-    void SendHttpResponse()
+    // 发送输出队列：套接字可写时由 reactor 调用，从上次停下的位置继续
+    // 返回 true 表示输出队列已全部发送；返回 false 且 stop 为 false 表示需要等待下一次可写（发送缓冲区满了或本次配额用完）
+    bool SendHttpResponse()
     {
-        // 发送响应行
-        send(sock, http_response.status_line.c_str(), http_response.status_line.size(), 0);
-        for (auto iter : http_response.response_header)
+        size_t quota = SEND_QUOTA;
+        cgi_wait = false;
+        cgi_exit_wait = false;
+        while (!outqueue.empty())
         {
-            send(sock, iter.c_str(), iter.size(), 0);
+            OutChunk &front = outqueue.front();
+            if (front.pipe)
+            {
+                if (!(front.chunked ? SendStream(front, quota) : SendPipe(front, quota)))
+                    return false;
+                CgiBufferPool::Put(front.data);
+                outqueue.pop_front();
+                if (corked)
+                    SetCork(false);
+                continue;
+            }
+            if (front.fd < 0)
+            {
+                // 响应头后面是 sendfile 发送的文件：先塞住套接字，让响应头和文件开头的数据合并在同一个报文段里
+                if (!corked && FileFollows())
+                    SetCork(true);
+                if (!SendChunks())
+                    return false;
+                continue;
+            }
+            if (!SendFile(front, quota))
+                return false;
+            close(front.fd);
+            outqueue.pop_front();
+            // 文件发完立即拔掉塞子，把文件末尾不满的报文段发出去，长连接上的下一个响应不会被延迟
+            if (corked)
+                SetCork(false);
         }
+        sending = false;
+        return true;
+    }
 
-        // 发送空行
-        send(sock, http_response.blank.c_str(), http_response.blank.size(), 0);
-
-        if (http_request.cgi) // 为 CGI 响应，响应体已经通过 CGI 程序生成，保存在 http_response.response_body 中
+    ~EndPoint()
+    {
+        for (auto &chunk : outqueue)
         {
-            auto &response_body = http_response.response_body;
-            size_t size = 0;  // 每次 send() 调用实际发送的字节数
-            size_t total = 0; // 已发送的字节数
-            const char *start = response_body.c_str();
-            while (total < response_body.size() && (size = send(sock, start + total, response_body.size() - total, 0)) > 0)
+            if (chunk.fd >= 0 && !chunk.pipe)
             {
-                total += size;
+                close(chunk.fd);
             }
         }
-        else // 将文件的内容发送给客户端
+        if (http_response.fd >= 0)
         {
-            // std::cout << ".............." << http_response.fd << std::endl;
-            // std::cout << ".............." << http_request.size << std::endl;
-            // 直接将文件从磁盘发送到客户端，而无需将文件内容读取到内存中。这可以减少 CPU 负担和内存拷贝的开销。
-            sendfile(sock, http_response.fd, nullptr, http_request.size);
             close(http_response.fd);
         }
-    }
-
-    ~EndPoint()
-    {
         close(sock);
     }
 };
@@ -654,45 +1634,43 @@ public:
     {
     }
 
-    // 仿函数，以便于：object(sock);
-    void operator()(int sock)
+    // 仿函数，以便于：object(ep, cls);
+    bool operator()(EndPoint *ep, int cls)
     {
-        HandlerRequest(sock);
+        return HandlerRequest(ep, cls);
     }
 
-    // 处理HTTP请求
-    void HandlerRequest(int sock)
+    // 处理HTTP请求：reactor 已经读到了完整的请求，这里只负责构建响应
+    // cls 是当前线程所在的线程池；返回 false 表示遇到了 CGI 请求，需要交给 CGI 线程池继续处理
+    bool HandlerRequest(EndPoint *ep, int cls)
     {
         INFO("%s", "Hander Request Begin...");
 
-#ifdef DEBUG_CODE // 获取浏览器的原生请求For Test
-        char buffer[4096];
-        recv(sock, buffer, sizeof(buffer), 0);
-        std::cout << "-------------begin----------------" << std::endl;
-        std::cout << buffer << std::endl;
-        std::cout << "-------------end----------------" << std::endl;
-#else
-        // 创建EndPoint对象，为了：读取请求，分析请求，构建响应
-        EndPoint *ep = new EndPoint(sock);
-
-        // 读取请求信息，若标志位为false，读取没有出错，开始构建和发送http响应
-        ep->RecvHttpRequest();
-        if (!ep->IsStop())
-        {
-            INFO("%s", "Recv No Error, Begin Build And Send");
-            ep->BuildHttpResponse();
-            ep->SendHttpResponse();
-        }
-        else
+        // 分析请求，构建响应（连同已经到达的流水线请求）
+        switch (ep->HandlerHttpRequests(cls))
         {
-            WARN("%s", "Recv Error, Stop Build And Send");
+        case HANDLE_HANDOFF:
+            return false;
+        case HANDLE_PENDING:
+            return true; // CGI 子进程结束后由 reactor 接着处理，这里不能再访问 ep
+        default:
+            break;
         }
 
-        // 释放对象
-        delete ep;
-#endif
+        // 响应交还给 reactor，由它在套接字可写时发送
+        ep->EnableWrite();
+
         // 处理完毕
         INFO("%s", "Hander Request Done...");
+        return true;
+    }
+
+    // 过载（队列管理判定请求已经等了太久，或者交给 CGI 线程池时队列满了）：不再构建响应，直接回复 503
+    void RejectRequest(EndPoint *ep)
+    {
+        WARN("%s", "overloaded, reply 503");
+        ep->PushServiceUnavailable();
+        ep->EnableWrite();
     }
 
     ~CallBack()
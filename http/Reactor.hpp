@@ -0,0 +1,419 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <ctime>
+#include "logs/mylog.h"
+#include "Utill.hpp"
+#include "Config.hpp"
+#include "Task.hpp"
+#include "ThreadPool.hpp"
+#include "Poller.hpp"
+#include "UringPoller.hpp"
+#include "Timer.hpp"
+#include "Stats.hpp"
+
+// 事件循环：I/O 后端（epoll 或 io_uring，见 Poller）持有所有非阻塞套接字，驱动 EndPoint 的读写
+// 请求读完整之后才交给线程池构建响应，构建完成后再交还给 reactor 发送
+// 连接使用 EPOLLONESHOT，保证同一时刻只有一个线程在操作某个 EndPoint
+class Reactor
+{
+private:
+    int listen_sock; // 监听套接字
+    Poller *poller;  // I/O 后端
+    bool stop;
+    ServerConfig config;
+    TimerWheel timers; // 各连接当前阶段的超时
+    int index;          // 第几个 reactor
+    unsigned next_home; // 轮流给新连接分配工作线程：只分配编号和 index 同余的，它们和这个 reactor 在同一个 NUMA 节点上（见 Placement）
+    std::unordered_map<int, EndPoint *> connections; // 所有连接，只在 reactor 线程中访问
+    std::unordered_set<EndPoint *> closing;          // 已关闭但后端还会送来一个事件的连接，收到后才释放
+    std::unordered_set<EndPoint *> orphans;          // 已关闭但 CGI 子进程还没结束的连接（流式发送时对端断开），子进程结束后才释放
+
+private:
+    // 连接数达到上限：不读请求，直接写入预先拼好的 503 响应后关闭（尽力而为，写不进去也不等待）
+    void ShedConnection(int sock)
+    {
+        send(sock, SERVICE_UNAVAILABLE_RESPONSE.data(), SERVICE_UNAVAILABLE_RESPONSE.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        close(sock);
+        ServerStats::getinstance()->shed_connections++;
+    }
+
+    // 接管一个新连接，开始等待它的请求
+    void NewConnection(int sock)
+    {
+        ServerStats *stats = ServerStats::getinstance();
+        stats->accepted++;
+        if (config.max_connections > 0 && stats->connections >= (uint64_t)config.max_connections)
+        {
+            WARN("%s", "too many connections, shed");
+            ShedConnection(sock);
+            return;
+        }
+        INFO("%s", "Get a new link");
+
+        EndPoint *ep = new EndPoint(sock, poller, config.keepalive_timeout > 0 ? config.max_requests : 1, next_home, config.cgi_output, config.status_page);
+        next_home += config.reactor_num;
+        if (!poller->Add(sock, EPOLLIN, ep))
+        {
+            delete ep;
+            return;
+        }
+        connections[sock] = ep;
+        stats->connections++;
+        ArmTimer(ep);
+    }
+
+    // 获取新连接：边缘触发，需要一直 accept 到没有新连接为止
+    void Accepter()
+    {
+        while (true)
+        {
+            struct sockaddr_in peer;
+            socklen_t len = sizeof(peer);
+            int sock = accept4(listen_sock, (struct sockaddr *)&peer, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (sock < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (!Utill::WouldBlock())
+                {
+                    WARN("%s", "accept error");
+                }
+                break;
+            }
+            NewConnection(sock);
+        }
+    }
+
+    // 套接字可读：继续读取请求，读完整后推送到任务队列
+    void Reader(EndPoint *ep)
+    {
+        if (ep->RecvHttpRequest())
+        {
+            INFO("%s", "Recv No Error, Begin Build And Send");
+            CancelTimer(ep); // 交给线程池之后不再计时
+            if (!ThreadPool::getinstance(POOL_STATIC)->TryPushTask(Task(ep), ep->Home()))
+            {
+                // 任务队列积压过多：请求在队列里等到处理时客户端可能已经放弃了，直接回复 503
+                WARN("%s", "task queue is full, shed");
+                ep->PushServiceUnavailable();
+                Writer(ep);
+            }
+        }
+        else if (ep->IsStop())
+        {
+            WARN("%s", "Recv Error, Stop Build And Send");
+            CloseConnection(ep);
+        }
+        else
+        {
+            ArmTimer(ep);
+            ep->EnableRead(); // 数据还没到齐
+        }
+    }
+
+    // CGI 子进程还在执行，连接等它的下一个事件：第一次等待时开始计算执行超时
+    // （已经在计时、套接字在等待发送、工作线程还持有连接或连接已经关闭时不动定时器）
+    void WaitCgi(EndPoint *ep)
+    {
+        if (ep->TimerPhase() == PHASE_NONE && ep->CgiHeldByReactor() && orphans.count(ep) == 0)
+        {
+            ArmCgiTimer(ep);
+        }
+    }
+
+    // CGI 子进程的管道或 pidfd 就绪：子进程执行完之后把连接交给 CGI 线程池，构建响应并接着处理流水线上后面的请求
+    // 流式发送时标准输出第一次有数据就把响应头放进输出队列，之后有数据就继续发送；
+    // 分块发送读完输出后要等子进程退出才能决定是否发送结束块
+    void CgiEvent(void *ptr)
+    {
+        int kind = 0;
+        CgiProcess *cgi = CgiProcess::FromEvent(ptr, kind);
+        EndPoint *ep = (EndPoint *)cgi->Owner();
+        switch (cgi->OnEvent(kind))
+        {
+        case CGI_EVENT_OUTPUT:
+            if (ep->CgiStreamed() || ep->BeginCgiStream())
+            {
+                Writer(ep);
+                return;
+            }
+            if (cgi->State() != CGI_DONE)
+            {
+                WaitCgi(ep); // 没有任何输出就关闭了标准输出，等子进程退出
+                return;
+            }
+            break;
+        case CGI_EVENT_NONE:
+            WaitCgi(ep);
+            return;
+        default:
+            break;
+        }
+        if (orphans.erase(ep))
+        {
+            if (closing.count(ep) == 0)
+                delete ep;
+            return;
+        }
+        if (ep->CgiStreamed())
+        {
+            if (ep->WaitingCgiExit())
+                Writer(ep);
+            return;
+        }
+        CancelTimer(ep);
+        if (!ThreadPool::getinstance(POOL_CGI)->TryPushTask(Task(ep, true), ep->Home()))
+        {
+            WARN("%s", "cgi task queue is full, build the finished cgi response in reactor");
+            ep->BuildCgiResponse();
+            Writer(ep);
+        }
+    }
+
+    // 套接字可写：继续发送输出队列；发送完毕后，长连接继续读取下一个请求，否则关闭连接
+    void Writer(EndPoint *ep)
+    {
+        if (ep->SendHttpResponse())
+        {
+            if (ep->CloseAfterSend())
+            {
+                CloseConnection(ep);
+            }
+            else
+            {
+                if (ep->CgiStreamed())
+                {
+                    ep->Reset(); // 分块发送的 CGI 响应发完了（子进程已经退出），这个请求才算处理完
+                }
+                Reader(ep); // 下一个请求可能已经有一部分在输入缓冲区中了
+            }
+        }
+        else if (ep->IsStop())
+        {
+            CloseConnection(ep);
+        }
+        else if (ep->WaitingCgiOutput())
+        {
+            ArmCgiTimer(ep); // 和 CGI 执行期间一样按执行超时计时
+            ep->EnableCgiOutput();
+        }
+        else if (ep->WaitingCgiExit())
+        {
+            ArmCgiTimer(ep); // 输出已经发完，子进程退出时 pidfd 就绪，reactor 再调用 Writer 发送结束块
+        }
+        else
+        {
+            ArmTimer(ep);
+            ep->EnableWrite(); // 发送缓冲区满了或本次配额用完，等待下一次可写（EPOLLONESHOT 重新注册时若仍可写会立即触发）
+        }
+    }
+
+    // 各阶段的超时（秒）
+    int PhaseTimeout(TimeoutPhase phase)
+    {
+        switch (phase)
+        {
+        case PHASE_REQUEST_LINE:
+            return config.request_line_timeout;
+        case PHASE_HEADER:
+            return config.header_timeout;
+        case PHASE_BODY:
+            return config.body_timeout;
+        case PHASE_SEND:
+            return config.send_timeout;
+        case PHASE_IDLE:
+            return config.keepalive_timeout;
+        default:
+            return 0;
+        }
+    }
+
+    // 连接开始等待事件之前按它所处的阶段设置定时器
+    // 接收请求时同一阶段的期限不因为收到数据而延长，每分钟发一个字节的客户端也会在期限到时被关闭；
+    // 发送响应时每次可写都重新计时，大文件下载不受总时长限制
+    void ArmTimer(EndPoint *ep)
+    {
+        TimeoutPhase phase = ep->Phase();
+        if (phase == ep->TimerPhase() && phase != PHASE_SEND && ep->Timer()->Pending())
+        {
+            return;
+        }
+        ep->SetTimerPhase(phase);
+        int timeout = PhaseTimeout(phase);
+        if (timeout > 0)
+        {
+            timers.Add(ep->Timer(), (uint64_t)timeout * 1000);
+        }
+        else
+        {
+            timers.Del(ep->Timer());
+        }
+    }
+
+    // 等待 CGI 子进程时的期限从子进程启动开始算，多次等待（流式发送时每次管道空了）不会延长
+    void ArmCgiTimer(EndPoint *ep)
+    {
+        if (config.cgi_timeout <= 0)
+        {
+            CancelTimer(ep);
+            return;
+        }
+        uint64_t deadline = ep->CgiStartMs() + (uint64_t)config.cgi_timeout * 1000;
+        uint64_t now = TimerWheel::NowMs();
+        ep->SetTimerPhase(PHASE_CGI);
+        timers.Add(ep->Timer(), deadline > now ? deadline - now : 0);
+    }
+
+    void CancelTimer(EndPoint *ep)
+    {
+        timers.Del(ep->Timer());
+        ep->SetTimerPhase(PHASE_NONE);
+    }
+
+    // 定时器只在连接等待事件时设置，到期时连接一定还在等待事件
+    // CGI 执行超时的时候等待的是子进程的描述符，套接字没有在等待：关闭连接时杀掉子进程，等它的描述符都关闭之后才释放连接
+    void OnTimeout(TimerNode *node)
+    {
+        EndPoint *ep = (EndPoint *)node->owner;
+        INFO("Close link, timeout in phase %d", (int)ep->TimerPhase());
+        CloseConnection(ep, ep->TimerPhase() != PHASE_CGI);
+    }
+
+    // armed：连接还在等待事件（超时的连接），io_uring 后端要等取消的 poll 完成之后才能释放 EndPoint
+    void CloseConnection(EndPoint *ep, bool armed = false)
+    {
+        timers.Del(ep->Timer());
+        connections.erase(ep->Sock());
+        ServerStats::getinstance()->connections--;
+        bool pending = poller->Del(ep->Sock(), ep, armed);
+        if (pending)
+        {
+            closing.insert(ep);
+        }
+        if (ep->AbandonCgi())
+        {
+            orphans.insert(ep); // 子进程的描述符还在 reactor 中，等它结束
+            return;
+        }
+        if (!pending)
+        {
+            delete ep; // 析构时关闭套接字
+        }
+    }
+
+    // 按配置创建 I/O 后端，io_uring 不可用（内核太旧或被禁用）时退回到 epoll
+    bool InitPoller()
+    {
+        if (config.backend == BACKEND_URING)
+        {
+            poller = new UringPoller();
+            if (poller->Init())
+            {
+                return true;
+            }
+            WARN("%s", "io_uring is not available, fall back to epoll");
+            delete poller;
+        }
+        poller = new EpollPoller();
+        return poller->Init();
+    }
+
+public:
+    Reactor(int _listen_sock, const ServerConfig &_config, int _index = 0)
+        : listen_sock(_listen_sock), poller(nullptr), stop(false), config(_config), index(_index), next_home(_index)
+    {
+    }
+
+    bool InitReactor()
+    {
+        if (!InitPoller())
+        {
+            FATAL("%s", "create poller error!");
+            return false;
+        }
+        INFO("I/O backend: %s", poller->Name());
+        if (!poller->AddListen(listen_sock))
+        {
+            FATAL("%s", "add listen sock error!");
+            return false;
+        }
+        return true;
+    }
+
+    void Loop()
+    {
+        Placement::getinstance()->PinReactor(index);
+        PollEvent events[MAX_EVENTS];
+        while (!stop)
+        {
+            // 有定时器的时候每个 tick 醒来一次推进时间轮
+            int n = poller->Wait(events, MAX_EVENTS, timers.Empty() ? -1 : TIMER_TICK_MS);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                ERROR("%s", "poller wait error!");
+                break;
+            }
+            for (int i = 0; i < n; i++)
+            {
+                EndPoint *ep = (EndPoint *)events[i].ptr;
+                if (ep == nullptr)
+                {
+                    if (events[i].res >= 0)
+                        NewConnection(events[i].res); // 后端已经 accept 好了
+                    else
+                        Accepter();
+                }
+                else if (CgiProcess::IsTagged(ep))
+                {
+                    CgiEvent(ep);
+                }
+                else if (!closing.empty() && closing.erase(ep))
+                {
+                    if (orphans.count(ep) == 0)
+                        delete ep; // 取消的事件已经送达，可以释放了
+                }
+                else if (events[i].events & EPOLLERR)
+                {
+                    CloseConnection(ep);
+                }
+                else if (ep->IsSending())
+                {
+                    Writer(ep);
+                }
+                else
+                {
+                    Reader(ep);
+                }
+            }
+            timers.Advance(TimerWheel::NowMs(), [this](TimerNode *node) { OnTimeout(node); });
+        }
+    }
+
+    ~Reactor()
+    {
+        for (auto &iter : connections)
+        {
+            delete iter.second;
+        }
+        for (auto ep : closing)
+        {
+            orphans.erase(ep);
+            delete ep;
+        }
+        for (auto ep : orphans)
+        {
+            delete ep;
+        }
+        delete poller;
+    }
+};
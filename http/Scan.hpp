@@ -0,0 +1,197 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86 1
+#endif
+
+// 解析 HTTP 请求时查找分隔符（'\r'/'\n'、':'、'?'、'.'）的扫描函数
+// 提供标量、SSE2（一次 16 字节）和 AVX2（一次 32 字节）三种实现，启动时按 CPU 支持的指令集选择一次，
+// 三种实现的结果完全相同；不需要额外的编译选项，AVX2 版本通过 target 属性单独编译
+class Scan
+{
+public:
+    typedef const char *(*FindAnyFn)(const char *p, const char *end, char a, char b);
+    typedef const char *(*FindLastFn)(const char *p, const char *end, char c);
+
+private:
+    struct Kernels
+    {
+        const char *name;
+        FindAnyFn find_any;
+        FindLastFn find_last;
+    };
+
+    // ---------- 标量实现 ----------
+    static const char *FindAnyScalar(const char *p, const char *end, char a, char b)
+    {
+        while (p < end && *p != a && *p != b)
+        {
+            p++;
+        }
+        return p;
+    }
+
+    static const char *FindLastScalar(const char *p, const char *end, char c)
+    {
+        for (const char *q = end; q > p; q--)
+        {
+            if (q[-1] == c)
+            {
+                return q - 1;
+            }
+        }
+        return end;
+    }
+
+#ifdef SCAN_X86
+    // ---------- SSE2：一次比较 16 字节 ----------
+    __attribute__((target("sse2"))) static const char *FindAnySse2(const char *p, const char *end, char a, char b)
+    {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        while (end - p >= 16)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i *)p);
+            int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+            if (mask != 0)
+            {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+        return FindAnyScalar(p, end, a, b);
+    }
+
+    __attribute__((target("sse2"))) static const char *FindLastSse2(const char *p, const char *end, char c)
+    {
+        const __m128i vc = _mm_set1_epi8(c);
+        const char *q = end;
+        while (q - p >= 16)
+        {
+            q -= 16;
+            int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)q), vc));
+            if (mask != 0)
+            {
+                return q + 31 - __builtin_clz(mask);
+            }
+        }
+        const char *r = FindLastScalar(p, q, c);
+        return r == q ? end : r;
+    }
+
+    // ---------- AVX2：一次比较 32 字节 ----------
+    __attribute__((target("avx2"))) static const char *FindAnyAvx2(const char *p, const char *end, char a, char b)
+    {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        while (end - p >= 32)
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i *)p);
+            unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb)));
+            if (mask != 0)
+            {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return FindAnySse2(p, end, a, b);
+    }
+
+    __attribute__((target("avx2"))) static const char *FindLastAvx2(const char *p, const char *end, char c)
+    {
+        const __m256i vc = _mm256_set1_epi8(c);
+        const char *q = end;
+        while (q - p >= 32)
+        {
+            q -= 32;
+            unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)q), vc));
+            if (mask != 0)
+            {
+                return q + 31 - __builtin_clz(mask);
+            }
+        }
+        const char *r = FindLastSse2(p, q, c);
+        return r == q ? end : r;
+    }
+#endif
+
+    static Kernels Detect()
+    {
+#ifdef SCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return {"avx2", FindAnyAvx2, FindLastAvx2};
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return {"sse2", FindAnySse2, FindLastSse2};
+        }
+#endif
+        return {"scalar", FindAnyScalar, FindLastScalar};
+    }
+
+    static Kernels &Current()
+    {
+        static Kernels kernels = Detect();
+        return kernels;
+    }
+
+public:
+    // 在 [p, end) 中查找第一个 a 或 b，没有则返回 end
+    static const char *FindAny(const char *p, const char *end, char a, char b)
+    {
+        return Current().find_any(p, end, a, b);
+    }
+
+    // 查找行尾：第一个 '\r' 或 '\n'
+    static const char *FindLineEnd(const char *p, const char *end)
+    {
+        return Current().find_any(p, end, '\r', '\n');
+    }
+
+    // 在 [p, end) 中查找第一个 c，没有则返回 end
+    static const char *FindChar(const char *p, const char *end, char c)
+    {
+        return Current().find_any(p, end, c, c);
+    }
+
+    // 在 [p, end) 中查找最后一个 c，没有则返回 end
+    static const char *FindLastChar(const char *p, const char *end, char c)
+    {
+        return Current().find_last(p, end, c);
+    }
+
+    // 当前使用的实现
+    static const char *KernelName()
+    {
+        return Current().name;
+    }
+
+    // 指定使用的实现（"scalar"、"sse2"、"avx2"），CPU 不支持时返回 false；用于压测和结果对比
+    static bool Select(const char *name)
+    {
+        if (strcmp(name, "scalar") == 0)
+        {
+            Current() = {"scalar", FindAnyScalar, FindLastScalar};
+            return true;
+        }
+#ifdef SCAN_X86
+        if (strcmp(name, "sse2") == 0 && __builtin_cpu_supports("sse2"))
+        {
+            Current() = {"sse2", FindAnySse2, FindLastSse2};
+            return true;
+        }
+        if (strcmp(name, "avx2") == 0 && __builtin_cpu_supports("avx2"))
+        {
+            Current() = {"avx2", FindAnyAvx2, FindLastAvx2};
+            return true;
+        }
+#endif
+        return false;
+    }
+};
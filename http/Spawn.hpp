@@ -0,0 +1,145 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <spawn.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#ifndef SYS_close_range
+#define SYS_close_range 436
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+#define SPAWN_CLOSEFROM 1 // posix_spawn 可以在子进程中关闭一段描述符（内部用 close_range）
+#endif
+
+#define SPAWN_STACK_SIZE (64 * 1024) // 没有 SPAWN_CLOSEFROM 时 clone 出的子进程用的栈
+
+extern char **environ;
+
+// 启动 CGI 程序，不用 fork：
+// fork 要复制整个服务器进程的页表（进程越大越慢），子进程还会继承所有客户端连接和缓存的文件描述符；
+// 这里子进程和父进程共享地址空间（posix_spawn 在 glibc 中就是 clone(CLONE_VM|CLONE_VFORK)），
+// 只做重定向、关闭其余描述符和 exec，父进程在子进程 exec 之后才继续
+// 环境变量在父进程中准备好（envp），子进程里不再调用 putenv
+class Spawn
+{
+private:
+    // 没有 SPAWN_CLOSEFROM 时 clone 出的子进程执行的函数：和父进程共享内存，只能调用 async-signal-safe 的函数
+    struct ChildArgs
+    {
+        const char *path;
+        char *const *argv;
+        char *const *envp;
+        int in_fd;
+        int out_fd;
+        int error; // exec 失败时的 errno，父进程在子进程退出后读取
+    };
+
+    static int ChildMain(void *arg)
+    {
+        ChildArgs *args = (ChildArgs *)arg;
+        setpgid(0, 0);
+        if (dup2(args->in_fd, 0) < 0 || dup2(args->out_fd, 1) < 0)
+        {
+            args->error = errno;
+            _exit(127);
+        }
+        if (syscall(SYS_close_range, 3, ~0U, 0) < 0)
+        {
+            for (int fd = 3; fd < sysconf(_SC_OPEN_MAX); fd++) // 内核早于 5.9
+            {
+                close(fd);
+            }
+        }
+        execve(args->path, args->argv, args->envp);
+        args->error = errno;
+        _exit(127);
+    }
+
+public:
+    // 服务器自己的环境变量（PATH 等）加上 vars，vars 中出现的名字覆盖原来的值
+    static std::vector<std::string> BuildEnv(const std::vector<std::string> &vars)
+    {
+        std::vector<std::string> env;
+        for (char **e = environ; *e != nullptr; e++)
+        {
+            const char *eq = strchr(*e, '=');
+            size_t name_len = eq == nullptr ? strlen(*e) : eq - *e;
+            bool replaced = false;
+            for (auto &var : vars)
+            {
+                if (var.size() > name_len && var[name_len] == '=' && var.compare(0, name_len, *e, name_len) == 0)
+                {
+                    replaced = true;
+                    break;
+                }
+            }
+            if (!replaced)
+            {
+                env.push_back(*e);
+            }
+        }
+        env.insert(env.end(), vars.begin(), vars.end());
+        return env;
+    }
+
+    // 执行 path：子进程的标准输入、标准输出分别是 in_fd、out_fd，标准错误和服务器相同，其余的描述符都关闭
+    // 子进程是一个新进程组的组长，放弃执行时连同它启动的进程（比如 shell 脚本里的命令）一起杀掉
+    // 成功返回子进程的 pid，失败返回 -1 并设置 errno（程序不存在、不能执行也在这里报告）
+    static pid_t Run(const char *path, const std::vector<std::string> &env, int in_fd, int out_fd)
+    {
+        std::vector<char *> envp;
+        envp.reserve(env.size() + 1);
+        for (auto &var : env)
+        {
+            envp.push_back((char *)var.c_str());
+        }
+        envp.push_back(nullptr);
+        char *argv[] = {(char *)path, nullptr};
+
+#ifdef SPAWN_CLOSEFROM
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, in_fd, 0);
+        posix_spawn_file_actions_adddup2(&actions, out_fd, 1);
+        posix_spawn_file_actions_addclosefrom_np(&actions, 3);
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attr, 0);
+        pid_t pid = -1;
+        int ret = posix_spawn(&pid, path, &actions, &attr, argv, envp.data());
+        posix_spawnattr_destroy(&attr);
+        posix_spawn_file_actions_destroy(&actions);
+        if (ret != 0)
+        {
+            errno = ret;
+            return -1;
+        }
+        return pid;
+#else
+        ChildArgs args = {path, argv, envp.data(), in_fd, out_fd, 0};
+        std::vector<char> stack(SPAWN_STACK_SIZE);
+        pid_t pid = clone(ChildMain, stack.data() + stack.size(), CLONE_VM | CLONE_VFORK | SIGCHLD, &args);
+        if (pid < 0)
+        {
+            return -1;
+        }
+        if (args.error != 0) // CLONE_VFORK：到这里子进程已经 exec 成功或者退出了
+        {
+            waitpid(pid, nullptr, 0);
+            errno = args.error;
+            return -1;
+        }
+        return pid;
+#endif
+    }
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include "Utill.hpp"
+
+#define STATUS_URI "/server-status" // 查看服务器计数器的路径
+
+// 请求的类别，每一类由自己的线程池处理（见 ThreadPool），计数器也分开
+#define POOL_STATIC 0  // 静态文件（以及错误页、状态页），不会长时间阻塞
+#define POOL_CGI 1     // CGI 程序，线程要等子进程执行完
+#define POOL_CLASSES 2
+static const char *POOL_NAMES[] = {"static", "cgi"};
+
+// 任务在线程池队列中等待时间的直方图，每个桶的上限（微秒），最后一个桶收集更长的
+static const uint64_t QUEUE_WAIT_BOUNDS[] = {100, 1000, 5000, 10000, 50000, 100000, 500000, 1000000};
+static const char *QUEUE_WAIT_NAMES[] = {"100us", "1ms", "5ms", "10ms", "50ms", "100ms", "500ms", "1s", "inf"};
+#define QUEUE_WAIT_BUCKETS (sizeof(QUEUE_WAIT_BOUNDS) / sizeof(QUEUE_WAIT_BOUNDS[0]) + 1)
+
+// 一个线程池（一类请求）的计数器
+struct PoolStats
+{
+    std::atomic<uint64_t> shed_requests;    // 因为任务队列达到上限，直接回复 503 的请求数
+    std::atomic<uint64_t> dropped_requests; // 出队时队列管理（Codel）判定过载，直接回复 503 的请求数
+    std::atomic<uint64_t> stolen_tasks;     // work-stealing 模式下从别的线程偷来的任务数
+    // 线程池的规模（见 ThreadPool 的 Resize）
+    std::atomic<uint64_t> threads;     // 当前的工作线程数
+    std::atomic<uint64_t> idle;        // 正在等待任务的线程数
+    std::atomic<uint64_t> blocked;     // 正在阻塞调用（等待 CGI 子进程）中的线程数
+    std::atomic<uint64_t> started;     // 累计扩容创建的线程数
+    std::atomic<uint64_t> retired;     // 累计因空闲超时退出的线程数
+    std::atomic<uint64_t> busy_us;     // 累计处理任务的时间（微秒）
+    std::atomic<uint64_t> blocked_us;  // 其中阻塞调用的时间（微秒）
+    std::atomic<uint64_t> blocked_pct; // 最近一个调整周期里处理任务的时间中阻塞所占的百分比
+    std::atomic<uint64_t> queue_wait[QUEUE_WAIT_BUCKETS]; // 队列等待时间的直方图（包括被拒绝的任务）
+
+    PoolStats() : shed_requests(0), dropped_requests(0), stolen_tasks(0),
+                  threads(0), idle(0), blocked(0), started(0), retired(0),
+                  busy_us(0), blocked_us(0), blocked_pct(0)
+    {
+        for (auto &bucket : queue_wait)
+        {
+            bucket = 0;
+        }
+    }
+
+    // 记录一个任务在队列中等待的时间（微秒）
+    void AddQueueWait(uint64_t us)
+    {
+        size_t i = 0;
+        while (i < QUEUE_WAIT_BUCKETS - 1 && us > QUEUE_WAIT_BOUNDS[i])
+        {
+            i++;
+        }
+        queue_wait[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 每行一个 "前缀名字: 值"
+    void Format(std::string &out, const std::string &prefix)
+    {
+        auto line = [&](const std::string &name, const std::atomic<uint64_t> &value) {
+            out += prefix + name + ": " + std::to_string(value.load(std::memory_order_relaxed)) + "\n";
+        };
+        line("shed_requests", shed_requests);
+        line("dropped_requests", dropped_requests);
+        line("stolen_tasks", stolen_tasks);
+        line("pool_threads", threads);
+        line("pool_idle", idle);
+        line("pool_blocked", blocked);
+        line("pool_started", started);
+        line("pool_retired", retired);
+        line("pool_busy_us", busy_us);
+        line("pool_blocked_us", blocked_us);
+        line("pool_blocked_pct", blocked_pct);
+        for (size_t i = 0; i < QUEUE_WAIT_BUCKETS; i++)
+        {
+            line(std::string("queue_wait_le_") + QUEUE_WAIT_NAMES[i], queue_wait[i]);
+        }
+    }
+};
+
+// 服务器的运行计数器，所有 reactor 和线程池共享，通过 STATUS_URI 以纯文本形式查看
+class ServerStats
+{
+public:
+    std::atomic<uint64_t> connections;      // 当前打开的连接数
+    std::atomic<uint64_t> accepted;         // 累计接受的连接数
+    std::atomic<uint64_t> shed_connections; // 因为连接数达到上限，直接回复 503 并关闭的连接数
+    PoolStats pools[POOL_CLASSES];          // 每一类请求的线程池
+    // FastCGI 后端（见 FastCgi）
+    std::atomic<uint64_t> fcgi_connections; // 当前打开的到后端的连接数
+    std::atomic<uint64_t> fcgi_requests;    // 累计交给后端处理的请求数
+    std::atomic<uint64_t> fcgi_failed;      // 其中连接出错或超时，回复 502 的请求数
+    std::atomic<uint64_t> fcgi_fallbacks;   // 连不上后端，改为直接执行本地 CGI 程序的请求数
+    // 由事件循环驱动的 CGI 子进程（见 CgiProcess）
+    std::atomic<uint64_t> cgi_running;      // 当前在执行的子进程数
+    std::atomic<uint64_t> cgi_processes;    // 累计启动的子进程数
+
+private:
+    ServerStats() : connections(0), accepted(0), shed_connections(0),
+                    fcgi_connections(0), fcgi_requests(0), fcgi_failed(0), fcgi_fallbacks(0),
+                    cgi_running(0), cgi_processes(0)
+    {
+    }
+
+    ServerStats(const ServerStats &) = delete;
+
+public:
+    static ServerStats *getinstance()
+    {
+        static ServerStats stats;
+        return &stats;
+    }
+
+    PoolStats *Pool(int cls)
+    {
+        return &pools[cls];
+    }
+
+    // 每行一个 "名字: 值"，线程池的计数器加上类别前缀（static_、cgi_），直方图每个桶一行（不累加）
+    std::string Format()
+    {
+        std::string out;
+        out += "connections: " + std::to_string(connections.load(std::memory_order_relaxed)) + "\n";
+        out += "accepted: " + std::to_string(accepted.load(std::memory_order_relaxed)) + "\n";
+        out += "shed_connections: " + std::to_string(shed_connections.load(std::memory_order_relaxed)) + "\n";
+        for (int cls = 0; cls < POOL_CLASSES; cls++)
+        {
+            pools[cls].Format(out, std::string(POOL_NAMES[cls]) + "_");
+        }
+        out += "fcgi_connections: " + std::to_string(fcgi_connections.load(std::memory_order_relaxed)) + "\n";
+        out += "fcgi_requests: " + std::to_string(fcgi_requests.load(std::memory_order_relaxed)) + "\n";
+        out += "fcgi_failed: " + std::to_string(fcgi_failed.load(std::memory_order_relaxed)) + "\n";
+        out += "fcgi_fallbacks: " + std::to_string(fcgi_fallbacks.load(std::memory_order_relaxed)) + "\n";
+        out += "cgi_running: " + std::to_string(cgi_running.load(std::memory_order_relaxed)) + "\n";
+        out += "cgi_processes: " + std::to_string(cgi_processes.load(std::memory_order_relaxed)) + "\n";
+        return out;
+    }
+};
+
+// 标记工作线程进入阻塞调用（等待 CGI 子进程的输出和退出），离开作用域时记录阻塞的时间
+// 线程池根据阻塞时间所占的比例决定要不要增加线程：线程都阻塞着时 CPU 是空闲的
+class BlockingScope
+{
+private:
+    PoolStats *stats;
+    uint64_t start;
+
+    BlockingScope(const BlockingScope &) = delete;
+
+public:
+    BlockingScope(PoolStats *_stats) : stats(_stats), start(Utill::NowUs())
+    {
+        stats->blocked.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    ~BlockingScope()
+    {
+        stats->blocked.fetch_sub(1, std::memory_order_relaxed);
+        stats->blocked_us.fetch_add(Utill::NowUs() - start, std::memory_order_relaxed);
+    }
+};
@@ -1,23 +1,82 @@
-#pragma once 
+#pragma once
 
 #include <iostream>
 #include "Protocol.hpp"
+#include "Job.hpp"
 
+// 线程池任务队列中的元素，只能移动：
+// 要么是一个已经读到完整请求的连接（由 CallBack 构建响应），要么是一个普通的任务（Job，见 ThreadPool::Submit）
 class Task{
     private:
-        int sock;
+        EndPoint *ep;     // 已经读到完整请求的连接，普通任务为空
+        bool resumed;     // CGI 子进程已经执行完，由 reactor 交回来构建响应（不能再拒绝，否则子进程的执行结果就丢了）
         CallBack handler; //设置回调
+        Job job;          // 普通任务
+        uint64_t enqueue_time; // 进入任务队列的时间（微秒）
     public:
-        Task()
+        Task():ep(nullptr), resumed(false), enqueue_time(0)
         {}
 
-        Task(int _sock):sock(_sock)
+        Task(EndPoint *_ep, bool _resumed = false):ep(_ep), resumed(_resumed), enqueue_time(0)
         {}
 
-        //处理任务
-        void ProcessOn()
+        Task(Job &&_job):ep(nullptr), resumed(false), job(std::move(_job)), enqueue_time(0)
+        {}
+
+        Task(Task &&) = default;
+        Task &operator=(Task &&) = default;
+        Task(const Task &) = delete;
+        Task &operator=(const Task &) = delete;
+
+        void SetEnqueueTime(uint64_t t)
+        {
+            enqueue_time = t;
+        }
+
+        uint64_t EnqueueTime()
+        {
+            return enqueue_time;
+        }
+
+        // 是不是 HTTP 请求：只有请求会被队列管理拒绝、转交给 CGI 线程池
+        bool IsRequest()
+        {
+            return ep != nullptr;
+        }
+
+        // 是不是子进程已经执行完的 CGI 请求：队列管理不拒绝它
+        bool IsResumed()
+        {
+            return resumed;
+        }
+
+        // 取回普通任务（提交失败时还给调用者）
+        Job TakeJob()
+        {
+            return std::move(job);
+        }
+
+        unsigned Home()
+        {
+            return ep->Home();
+        }
+
+        //处理任务：cls 是当前线程所在的线程池，返回 false 表示需要交给 CGI 线程池继续处理
+        bool ProcessOn(int cls)
+        {
+            if (ep == nullptr)
+            {
+                job();
+                job = Job(); // 立即释放闭包捕获的资源，不留到下一个任务覆盖它的时候
+                return true;
+            }
+            return handler(ep, cls);// 在回调函数内部重载()，构成仿函数
+        }
+
+        // 过载，不处理任务，直接回复 503
+        void Reject()
         {
-            handler(sock);// 在回调函数内部重载()，构成仿函数
+            handler.RejectRequest(ep);
         }
 
         ~Task()
@@ -10,19 +10,21 @@
 #include <arpa/inet.h>
 #include <pthread.h>
 #include <unistd.h>
+#include "Utill.hpp"
 
-#define BACKLOG 5 // 定义连接队列的最大长度为 5
+#define BACKLOG 1024 // 定义连接队列的最大长度为 1024（实际还受 somaxconn 限制）
 
 class TcpServer
 {
 private:
     int port;              // 保存服务器的端口号
     int listen_sock;       // 服务器监听套接字
+    bool reuse_port;       // 是否开启 SO_REUSEPORT（多 reactor 模式）
     static TcpServer *svr; // 静态指针，指向类的单例实例
 
 private:
     // 私有构造函数，防止外部创建实例，默认端口号为 PORT
-    TcpServer(int _port) : port(_port), listen_sock(-1) {}
+    TcpServer(int _port, bool _reuse_port = false) : port(_port), listen_sock(-1), reuse_port(_reuse_port) {}
 
     // 私有拷贝构造函数，禁止复制对象
     TcpServer(const TcpServer &s) {}
@@ -46,6 +48,15 @@ public:
         return svr; // 返回单例实例
     }
 
+    // 多 reactor 模式：每个 reactor 各自创建一个开启了 SO_REUSEPORT 的监听套接字，
+    // 绑定同一个端口，由内核把新连接分配到各个监听套接字上，accept 不再争抢同一个队列
+    static TcpServer *NewReusePortServer(int port)
+    {
+        TcpServer *s = new TcpServer(port, true);
+        s->InitServer();
+        return s;
+    }
+
     // 初始化服务器的方法，包括创建套接字、绑定端口和监听
     void InitServer()
     {
@@ -66,6 +77,13 @@ public:
         int opt = 1;
         // 设置套接字选项，启用端口地址复用
         setsockopt(listen_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        if (reuse_port && setsockopt(listen_sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0)
+        {
+            FATAL("%s", "设置 SO_REUSEPORT 失败...");
+            exit(1);
+        }
+        // 由 reactor 在边缘触发模式下循环 accept，监听套接字必须是非阻塞的
+        Utill::SetNonBlock(listen_sock);
     }
 
     // 绑定套接字到指定端口
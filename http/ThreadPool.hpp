@@ -1,50 +1,124 @@
 #pragma once
 
 #include <iostream>
-#include <queue>
-#include <pthread.h> //同步互斥
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <pthread.h>
+#include <unistd.h>
 #include "logs/mylog.h"
 #include "Task.hpp"
+#include "Codel.hpp"
+#include "Stats.hpp"
+#include "Utill.hpp"
+#include "MpmcQueue.hpp"
+#include "WsDeque.hpp"
+#include "Config.hpp"
+#include "Placement.hpp"
+#include "Job.hpp"
 
-#define NUM 6
+#define TASK_QUEUE_CAPACITY 65536 // 不限制积压的请求数时任务队列的容量
+#define STEAL_BATCH 8              // work-stealing 模式下每次从收件箱搬到自己的双端队列的任务数
+#define THREADS_PER_CPU 8          // 不指定时最多线程数是 CPU 个数的这么多倍（给阻塞在 CGI 上的线程留余量）
+#define THREAD_IDLE_TIMEOUT 10000  // 线程数多于下限时，空闲超过这个时间（毫秒）的线程退出
+#define RESIZE_INTERVAL_MS 100     // 调整线程数的周期（毫秒）
 
+// 每一类请求（POOL_STATIC、POOL_CGI）有自己的线程池，线程数、队列上限、队列管理和计数器都是独立的：
+// reactor 把请求交给静态线程池，解析完路径发现是 CGI 的再转交给 CGI 线程池，
+// 慢的 CGI 程序占满了 CGI 线程池也不会影响静态文件
+// 线程数在 [min_threads, max_threads] 之间自动调整（见 Resize）：
+//   有任务在排队、没有空闲线程时，按处理任务的时间中阻塞所占的比例增加线程，
+//   阻塞的比例为 b 时大约需要 CPU 个数 / (1 - b) 个线程才能让 CPU 忙起来，纯计算的任务不再增加线程；
+//   空闲超过 THREAD_IDLE_TIMEOUT 的线程退出，直到只剩 min_threads 个
+//   每次调整都写日志，当前的线程数和累计的调整次数在 STATUS_URI 中可以看到（-s 开启）
+// 除了 HTTP 请求，线程池也执行普通的任务（Post / Submit / SubmitBatch）：任何只能移动的无参可调用对象，
+// 小的闭包不分配内存（见 Job），Submit 返回 Future；后台任务和请求共用线程和队列，不需要另外的线程
+// 任务队列是无锁的有界队列，入队和出队都不加锁；任务在队列中只移动，不复制；
+// 空闲的线程在 EventCount 的 futex 上睡眠，只有确实有线程在睡眠时入队才需要唤醒
+// 两种模式：
+//   POOL_GLOBAL：一个共享的 MpmcQueue，哪个线程空闲就由哪个线程处理
+//   POOL_STEAL：每个线程一个收件箱（MpmcQueue，reactor 按连接投递）和一个 Chase-Lev 双端队列，
+//     同一个连接的后续请求总是投递给同一个线程，数据留在同一个核的缓存里；
+//     线程先做自己的任务，收件箱里的任务成批搬进双端队列，空闲的线程从别人的双端队列顶部偷任务，
+//     别人的收件箱里积压的任务也可以直接拿走，突发时负载仍然均衡
 class ThreadPool
 {
 private:
-    int num; // 线程数目
+    // work-stealing 模式下每个线程自己的队列
+    // 线程数可以变化，按最多的线程数分配，每个线程占用一个空闲的位置
+    struct Worker
+    {
+        MpmcQueue<Task> inbox;    // 投递给这个线程的任务
+        WsDeque<Task> deque;      // 这个线程正在处理的一批任务
+        std::atomic<bool> alive;  // 这个位置上有没有线程
+
+        Worker(size_t capacity) : inbox(capacity), deque(STEAL_BATCH), alive(false) {}
+    };
+
+    // 传给线程函数的参数
+    struct WorkerArgs
+    {
+        ThreadPool *tp;
+        int id;
+    };
+
+    int cls;          // 处理哪一类请求
+    PoolStats *stats; // 这一类请求的计数器
+    int min_threads; // 线程数的下限
+    int max_threads; // 线程数的上限
+    int cpus;        // CPU 个数
+    std::atomic<int> num; // 当前的线程数目
     bool stop;
-    std::queue<Task> task_queue; // 任务队列
-    pthread_mutex_t lock;        // 锁
-    pthread_cond_t cond;         // 条件变量
+    int mode;                   // POOL_GLOBAL 或 POOL_STEAL
+    MpmcQueue<Task> task_queue; // 任务队列（POOL_GLOBAL）
+    std::vector<std::unique_ptr<Worker>> workers; // 每个线程的位置，POOL_STEAL 模式下还有它的队列
+    EventCount idle;            // 等待任务的线程
+    Codel codel;                // 出队时的队列管理
+    pthread_mutex_t resize_mutex; // 创建和退出线程时加锁
+    pthread_cond_t resize_cond;   // 所有线程都阻塞时立即叫醒调整线程数的线程
+    std::atomic<unsigned> job_hint; // work-stealing 模式下普通任务轮流投递给各个线程
 
-    // 构造函数：默认线程数量是5
-    ThreadPool(int _num = NUM) : num(_num), stop(false)
+    // 构造函数：线程数的上下限为 0 时根据 CPU 个数决定，任务队列的容量向上取整到 2 的幂
+    // work-stealing 模式下容量平均分给下限个数的收件箱（只往有线程的位置投递）
+    ThreadPool(int _cls, size_t capacity, int _mode, int _min_threads, int _max_threads)
+        : cls(_cls), stats(ServerStats::getinstance()->Pool(_cls)), num(0), stop(false), mode(_mode),
+          task_queue(_mode == POOL_GLOBAL ? capacity : 1), job_hint(0)
     {
-        pthread_mutex_init(&lock, nullptr); // 初始化
-        pthread_cond_init(&cond, nullptr);
+        cpus = std::max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+        min_threads = _min_threads > 0 ? _min_threads : cpus;
+        max_threads = _max_threads > 0 ? _max_threads : cpus * THREADS_PER_CPU;
+        max_threads = std::max(max_threads, min_threads);
+        for (int i = 0; i < max_threads; i++)
+        {
+            workers.emplace_back(new Worker(mode == POOL_STEAL ? (capacity + min_threads - 1) / min_threads : 1));
+        }
+        pthread_mutex_init(&resize_mutex, nullptr);
+        pthread_cond_init(&resize_cond, nullptr);
     }
 
-    ThreadPool(const ThreadPool &) {}
+    ThreadPool(const ThreadPool &) = delete;
 
-    // 线程池单例
-    static ThreadPool *single_instance;
+    // 每一类请求一个单例
+    static ThreadPool *instances[POOL_CLASSES];
 
 public:
-    // 获取单例
-    static ThreadPool *getinstance()
+    // 获取 cls 类请求的线程池：其余参数只在第一次调用、创建线程池时生效，queue_capacity 为 0 表示 TASK_QUEUE_CAPACITY，
+    // min_threads 为 0 表示 CPU 个数，max_threads 为 0 表示 CPU 个数的 THREADS_PER_CPU 倍
+    static ThreadPool *getinstance(int cls = POOL_STATIC, size_t queue_capacity = 0, int mode = POOL_GLOBAL, int min_threads = 0, int max_threads = 0)
     {
         static pthread_mutex_t _mutex = PTHREAD_MUTEX_INITIALIZER;
-        if (single_instance == nullptr)
+        if (instances[cls] == nullptr)
         {
             pthread_mutex_lock(&_mutex);
-            if (single_instance == nullptr)
+            if (instances[cls] == nullptr)
             {
-                single_instance = new ThreadPool();
-                single_instance->InitThreadPool();
+                ThreadPool *tp = new ThreadPool(cls, queue_capacity > 0 ? queue_capacity : TASK_QUEUE_CAPACITY, mode, min_threads, max_threads);
+                tp->InitThreadPool();
+                instances[cls] = tp;
             }
             pthread_mutex_unlock(&_mutex);
         }
-        return single_instance;
+        return instances[cls];
     }
 
     bool IsStop() // 线程是否退出
@@ -52,86 +126,406 @@ public:
         return stop;
     }
 
+    // 线程要执行的方法必须是静态的，因为它默认的参数只有一个
+    static void *ThreadRoutine(void *args) /// 线程处理
+    {
+        WorkerArgs *wa = (WorkerArgs *)args;
+        ThreadPool *tp = wa->tp; // 要读取的线程池的指针
+        int id = wa->id;         // 线程的编号
+        delete wa;
+        Placement::getinstance()->PinWorker(id);
+
+        PoolStats *stats = tp->stats;
+        Task t;
+        while (tp->PopTask(id, t)) // 空闲超时退出时返回 false
+        {
+            uint64_t start = Utill::NowUs();
+            if (tp->ShouldDrop(t))
+                t.Reject(); // 等得太久，客户端很可能已经放弃了，不再花时间处理
+            else if (!t.ProcessOn(tp->cls)) // 处理任务，回调
+                tp->Handoff(t); // 是 CGI 请求
+            stats->busy_us.fetch_add(Utill::NowUs() - start, std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
+    // 调整线程数的线程
+    static void *ResizeRoutine(void *args)
+    {
+        ThreadPool *tp = (ThreadPool *)args;
+        tp->Resize();
+        return nullptr;
+    }
+
+    bool InitThreadPool() // 1.初始化
+    {
+        if (Spawn(min_threads) < min_threads)
+        {
+            FATAL("%s", "create thread pool error!");
+            return false;
+        }
+        pthread_t tid;
+        if (min_threads < max_threads)
+        {
+            if (pthread_create(&tid, nullptr, ResizeRoutine, this) != 0)
+            {
+                FATAL("%s", "create thread pool error!");
+                return false;
+            }
+            pthread_detach(tid);
+        }
+        INFO("create %s thread pool success, mode: %s, threads: %d-%d", POOL_NAMES[cls],
+             mode == POOL_STEAL ? "work-stealing" : "global queue", min_threads, max_threads);
+        return true;
+    }
+
+    // 在空闲的位置上创建最多 n 个线程，返回创建的个数
+    int Spawn(int n)
+    {
+        int started = 0;
+        pthread_mutex_lock(&resize_mutex);
+        for (int i = 0; i < max_threads && started < n; i++)
+        {
+            Worker *w = workers[i].get();
+            if (w->alive.load(std::memory_order_relaxed))
+            {
+                continue;
+            }
+            w->alive.store(true, std::memory_order_release);
+            pthread_t tid;
+            if (pthread_create(&tid, nullptr, ThreadRoutine, new WorkerArgs{this, i}) != 0)
+            {
+                w->alive.store(false, std::memory_order_relaxed);
+                ERROR("%s", "create thread error!");
+                break;
+            }
+            pthread_detach(tid);
+            started++;
+        }
+        num.fetch_add(started);
+        stats->threads.fetch_add(started, std::memory_order_relaxed);
+        pthread_mutex_unlock(&resize_mutex);
+        return started;
+    }
 
-    bool TaskQueueIsEmpty()
+    // 空闲超时的线程申请退出，线程数已经到了下限时返回 false
+    bool Retire(int id)
     {
-        return task_queue.size() == 0 ? true : false;
+        bool ok = false;
+        pthread_mutex_lock(&resize_mutex);
+        if (num.load() > min_threads)
+        {
+            num.fetch_sub(1);
+            workers[id]->alive.store(false, std::memory_order_release);
+            stats->threads.fetch_sub(1, std::memory_order_relaxed);
+            stats->retired.fetch_add(1, std::memory_order_relaxed);
+            ok = true;
+        }
+        pthread_mutex_unlock(&resize_mutex);
+        if (ok)
+        {
+            INFO("%s thread pool shrink: %d threads, idle for %d ms", POOL_NAMES[cls], num.load(), THREAD_IDLE_TIMEOUT);
+        }
+        return ok;
     }
 
+    // 排队等待的任务数（近似值）
+    size_t Queued()
+    {
+        if (mode == POOL_GLOBAL)
+        {
+            return task_queue.Size();
+        }
+        size_t queued = 0;
+        for (auto &w : workers)
+        {
+            queued += w->inbox.Size() + w->deque.Size();
+        }
+        return queued;
+    }
 
-    void Lock() // 加锁
+    // 每 RESIZE_INTERVAL_MS 检查一次：有任务在排队并且没有空闲的线程时，
+    // 按最近一个周期里阻塞时间的比例计算需要的线程数，不够就增加（不超过排队的任务数）
+    void Resize()
     {
-        pthread_mutex_lock(&lock);
+        uint64_t last_busy = stats->busy_us.load(std::memory_order_relaxed);
+        uint64_t last_blocked = stats->blocked_us.load(std::memory_order_relaxed);
+        while (!stop)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_nsec += RESIZE_INTERVAL_MS * 1000000L;
+            ts.tv_sec += ts.tv_nsec / 1000000000L;
+            ts.tv_nsec %= 1000000000L;
+            pthread_mutex_lock(&resize_mutex);
+            pthread_cond_timedwait(&resize_cond, &resize_mutex, &ts);
+            pthread_mutex_unlock(&resize_mutex);
+
+            // 阻塞的比例：周期内的阻塞时间 / 处理任务的时间；还没有处理完的任务按当前阻塞的线程数估计
+            uint64_t busy = stats->busy_us.load(std::memory_order_relaxed);
+            uint64_t blocked_us = stats->blocked_us.load(std::memory_order_relaxed);
+            uint64_t d_busy = busy - last_busy, d_blocked = blocked_us - last_blocked;
+            last_busy = busy;
+            last_blocked = blocked_us;
+            int threads = num.load();
+            int blocked = stats->blocked.load(std::memory_order_relaxed);
+            double ratio = d_busy > 0 ? std::min(1.0, (double)d_blocked / d_busy) : 0.0;
+            ratio = std::max(ratio, (double)blocked / threads);
+            stats->blocked_pct.store((uint64_t)(ratio * 100), std::memory_order_relaxed);
+
+            size_t queued = Queued();
+            if (queued == 0 || stats->idle.load(std::memory_order_relaxed) > 0 || threads >= max_threads)
+            {
+                continue;
+            }
+            int target = ratio >= 1.0 ? max_threads : (int)std::min<double>(max_threads, cpus / (1.0 - ratio) + 0.5);
+            int add = std::min<int>(target - threads, queued);
+            if (add <= 0)
+            {
+                continue; // CPU 已经够忙了，再加线程只会增加切换
+            }
+            add = Spawn(add);
+            stats->started.fetch_add(add, std::memory_order_relaxed);
+            INFO("%s thread pool grow: %d threads (+%d), queued %zu, blocked %d%%", POOL_NAMES[cls], num.load(), add, queued, (int)(ratio * 100));
+        }
     }
 
-    void Unlock() // 解锁
+    // 设置队列管理的目标等待时间和观察窗口（毫秒），target_ms 为 0 表示不做队列管理
+    void SetQueueTarget(int target_ms, int interval_ms)
     {
-        pthread_mutex_unlock(&lock);
+        codel.SetTarget(target_ms, interval_ms);
     }
 
-    void ThreadWait() // 线程等待
+    // 出队后记录任务的等待时间，并由 Codel 判断是否拒绝；普通任务和 CGI 子进程执行完交回来的请求不会被拒绝，也不影响队列管理
+    bool ShouldDrop(Task &task)
     {
-        pthread_cond_wait(&cond, &lock);
+        uint64_t now = Utill::NowUs();
+        uint64_t delay = now - task.EnqueueTime();
+        stats->AddQueueWait(delay);
+        if (task.IsRequest() && !task.IsResumed() && codel.ShouldDrop(delay, now))
+        {
+            stats->dropped_requests++;
+            return true;
+        }
+        return false;
     }
 
-    void ThreadWakeup() // 线程唤醒
+    int MaxThreads()
     {
-        pthread_cond_signal(&cond);
+        return max_threads;
     }
 
-    // 线程要执行的方法必须是静态的，因为它默认的参数只有一个
-    static void *ThreadRoutine(void *args) /// 线程处理
+    int ThreadNum()
     {
-        ThreadPool *tp = (ThreadPool *)args; // 要读取的线程池的指针
+        return num.load(std::memory_order_relaxed);
+    }
 
-        while (true)
+    // 静态线程池遇到 CGI 请求：转交给 CGI 线程池，它的队列满了就直接回复 503
+    void Handoff(Task &task)
+    {
+        if (!getinstance(POOL_CGI)->TryPushTask(std::move(task), task.Home()))
         {
-            Task t;
-            tp->Lock(); /// 下面的while防止伪唤醒
-            while (tp->TaskQueueIsEmpty())
+            WARN("%s", "cgi task queue is full, shed");
+            task.Reject();
+        }
+    }
+
+    // 推送到任务队列：队列满了（积压过多）返回 false，task 保持不变
+    // hint：work-stealing 模式下优先投递给哪个线程（同一个连接总是使用同一个值），它的收件箱满了或者线程已经退出时投递给其他线程
+    bool TryPushTask(Task &&task, unsigned hint = 0)
+    {
+        if (!Enqueue(std::move(task), hint))
+        {
+            if (task.IsRequest() && !task.IsResumed())
             {
-                tp->ThreadWait(); // 当我醒来的时候，一定是占有互斥锁的！
+                stats->shed_requests++; // 执行完的 CGI 请求不会被拒绝，由 reactor 直接构建响应
             }
-            tp->PopTask(t);
-            tp->Unlock();
-            t.ProcessOn(); // 处理任务，回调
+            return false;
         }
+        Wake(1);
+        return true;
     }
 
-    bool InitThreadPool() // 1.初始化
+    // 提交一个普通任务，不关心结果；队列满了返回 false
+    template <class F>
+    bool Post(F &&f)
     {
-        for (int i = 0; i < num; i++)
+        return TryPushTask(Task(Job(std::forward<F>(f))), job_hint.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    // 提交一个普通任务，返回它的 Future；队列满了时返回的 Future 的 Valid() 为 false
+    // 结果和闭包分开分配：Future 的共享状态分配一次，闭包（连同指向共享状态的指针）小的话仍然放在 Job 里
+    template <class F, class R = typename std::invoke_result<typename std::decay<F>::type &>::type>
+    Future<R> Submit(F &&f)
+    {
+        FutureState<R> *state = new FutureState<R>();
+        Future<R> future(state);
+        typedef typename std::decay<F>::type D;
+        if (!Post(PromiseJob<D, R>(D(std::forward<F>(f)), state)))
         {
-            pthread_t tid;
-            if (pthread_create(&tid, nullptr, ThreadRoutine, this) != 0)
+            return Future<R>(); // 没有入队的 PromiseJob 已经把共享状态标记为放弃，future 析构时释放
+        }
+        return future;
+    }
+
+    // 批量提交普通任务：按顺序入队，队列满了就停下，全部入队之后再按个数唤醒线程
+    // 已经入队的从 jobs 中移除，返回入队的个数；没有入队的留在 jobs 里，调用者可以稍后再提交
+    size_t SubmitBatch(std::vector<Job> &jobs)
+    {
+        size_t done = 0;
+        unsigned hint = job_hint.fetch_add(jobs.size(), std::memory_order_relaxed);
+        while (done < jobs.size())
+        {
+            Task t(std::move(jobs[done]));
+            if (!Enqueue(std::move(t), hint + done))
             {
-                FATAL("%s", "create thread pool error!");
-                return false;
+                jobs[done] = t.TakeJob();
+                break;
             }
+            done++;
         }
-        INFO("%s", "create thread pool success!");
-        return true;
+        jobs.erase(jobs.begin(), jobs.begin() + done);
+        Wake(done);
+        return done;
     }
 
-    void PushTask(const Task &task) // in2.推送到任务队列
+    bool PushTo(int id, Task &task)
     {
-        Lock();
-        task_queue.push(task);
-        Unlock();
-        ThreadWakeup();
+        Worker *w = workers[id].get();
+        return w->alive.load(std::memory_order_acquire) && w->inbox.TryPush(std::move(task));
     }
 
-    void PopTask(Task &task) // out3.拿出任务从队列
+    // 放进任务队列，不唤醒线程；失败时 task 保持不变
+    // work-stealing 模式下按 hint 选线程：reactor 给连接分配的 hint 和它的编号同余（见 Reactor::next_home），
+    // 先在编号同余的线程（和这个 reactor 在同一个节点上）中轮流选，收件箱满了或者线程已经退出时
+    // 再试同一个节点上的其他线程，最后才投递给任意线程
+    bool Enqueue(Task &&task, unsigned hint)
     {
-        task = task_queue.front();
-        task_queue.pop();
+        task.SetEnqueueTime(Utill::NowUs());
+        if (mode == POOL_GLOBAL)
+        {
+            return task_queue.TryPush(std::move(task));
+        }
+        Placement *placement = Placement::getinstance();
+        int groups = std::max(1, placement->ReactorNum());
+        int group = hint % groups;
+        int peers = group < max_threads ? (max_threads - group + groups - 1) / groups : 0; // 编号为 group、group + groups ... 的线程数
+        for (int i = 0; i < peers; i++)
+        {
+            if (PushTo(group + (int)((hint / groups + i) % peers) * groups, task))
+            {
+                return true;
+            }
+        }
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int i = 0; i < max_threads; i++)
+            {
+                int id = (hint + i) % max_threads;
+                if (id % groups == group || (pass == 0) != placement->SameNode(id, group))
+                {
+                    continue; // 同余的已经试过；第一轮只试同一个节点上的
+                }
+                if (PushTo(id, task))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // 新入队了 n 个任务：最多唤醒 n 个睡眠的线程
+    void Wake(size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            idle.Notify();
+        }
+        // 所有线程都阻塞着，不等下一个调整周期，立即增加线程
+        int threads = num.load(std::memory_order_relaxed);
+        if (n > 0 && threads < max_threads && (int)stats->blocked.load(std::memory_order_relaxed) >= threads)
+        {
+            pthread_cond_signal(&resize_cond);
+        }
+    }
+
+    // 从任务队列取出一个任务，队列为空时睡眠等待；空闲超时、线程应该退出时返回 false
+    bool PopTask(int id, Task &task)
+    {
+        uint64_t idle_since = 0;
+        while (!FindTask(id, task))
+        {
+            // 在宣布睡眠之前退出：不会领走 Notify 给其他线程的唤醒
+            if (idle_since > 0 && Utill::NowUs() - idle_since >= THREAD_IDLE_TIMEOUT * 1000ULL && Retire(id))
+            {
+                return false;
+            }
+            uint32_t key = idle.PrepareWait();
+            if (FindTask(id, task)) // 宣布睡眠之后再检查一次，避免错过刚入队的任务
+            {
+                idle.CancelWait();
+                return true;
+            }
+            if (idle_since == 0)
+            {
+                idle_since = Utill::NowUs();
+            }
+            stats->idle.fetch_add(1, std::memory_order_relaxed);
+            idle.Wait(key, THREAD_IDLE_TIMEOUT);
+            stats->idle.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // 不阻塞地找一个任务
+    bool FindTask(int id, Task &task)
+    {
+        if (mode == POOL_GLOBAL)
+        {
+            return task_queue.TryPop(task);
+        }
+
+        // 1. 自己双端队列里的任务
+        Worker *self = workers[id].get();
+        if (self->deque.Take(task))
+        {
+            return true;
+        }
+        // 2. 自己的收件箱：取一个处理，再搬一批进双端队列，忙不过来时别的线程可以偷走
+        if (self->inbox.TryPop(task))
+        {
+            Task more;
+            int moved = 0;
+            // 只有自己往双端队列里放，CanPush 成立时 Push 一定成功
+            while (moved < STEAL_BATCH && self->deque.CanPush() && self->inbox.TryPop(more))
+            {
+                self->deque.Push(std::move(more));
+                moved++;
+            }
+            if (moved > 0)
+            {
+                idle.Notify(); // 有可以偷的任务了
+            }
+            return true;
+        }
+        // 3. 从别的线程那里偷：先偷双端队列里的，再拿收件箱里积压的
+        //    也检查已经退出的线程的位置，它退出前刚投递进去的任务不会被遗漏
+        for (int i = 1; i < max_threads; i++)
+        {
+            Worker *victim = workers[(id + i) % max_threads].get();
+            if (victim->deque.Steal(task) || victim->inbox.TryPop(task))
+            {
+                stats->stolen_tasks.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
     }
 
-    ~ThreadPool() 
+    ~ThreadPool()
     {
-        pthread_mutex_destroy(&lock); // 释放
-        pthread_cond_destroy(&cond);
     }
 };
 
-ThreadPool *ThreadPool::single_instance = nullptr;
\ No newline at end of file
+ThreadPool *ThreadPool::instances[POOL_CLASSES] = {nullptr};
\ No newline at end of file
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+#define TIMER_TICK_MS 100    // 时间轮的精度（毫秒）
+#define TIMER_WHEEL_BITS 6   // 每一层 64 个槽
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+#define TIMER_WHEEL_LEVELS 4 // 四层：6.4 秒、6.8 分钟、7.3 小时、19 天
+
+// 定时器节点，嵌入在被定时的对象中（侵入式双向链表），加入和删除都不需要分配内存
+struct TimerNode
+{
+    TimerNode *prev;
+    TimerNode *next;
+    uint64_t expire; // 到期的 tick
+    void *owner;     // 所属的对象
+
+    TimerNode(void *_owner = nullptr) : prev(nullptr), next(nullptr), expire(0), owner(_owner) {}
+
+    bool Pending()
+    {
+        return prev != nullptr;
+    }
+};
+
+// 分层时间轮：第 0 层每个槽是一个 tick，第 l 层每个槽是 64^l 个 tick
+// 定时器按剩余时间放进对应的层，上一层的槽转到时再把其中的定时器重新分配到下面的层
+// Add/Del 都是 O(1)，Advance 每个 tick 只处理一个槽；只在 reactor 线程中使用，不加锁
+class TimerWheel
+{
+private:
+    TimerNode slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE]; // 每个槽是一个带哨兵的循环链表
+    uint64_t current; // 已经处理到的 tick
+    size_t count;     // 还没到期的定时器个数
+
+private:
+    static void Unlink(TimerNode *node)
+    {
+        node->prev->next = node->next;
+        node->next->prev = node->prev;
+        node->prev = node->next = nullptr;
+    }
+
+    static void LinkTail(TimerNode *head, TimerNode *node)
+    {
+        node->prev = head->prev;
+        node->next = head;
+        head->prev->next = node;
+        head->prev = node;
+    }
+
+    // 按剩余的 tick 数选择层和槽
+    void Link(TimerNode *node)
+    {
+        uint64_t diff = node->expire > current ? node->expire - current : 0;
+        int level = 0;
+        while (level < TIMER_WHEEL_LEVELS - 1 && diff >= (1ULL << (TIMER_WHEEL_BITS * (level + 1))))
+        {
+            level++;
+        }
+        if (level == TIMER_WHEEL_LEVELS - 1 && diff >= (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)))
+        {
+            node->expire = current + (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1; // 超出范围的按最大时间处理
+        }
+        LinkTail(&slots[level][(node->expire >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK], node);
+    }
+
+    // 把一个槽的链表整体移到 list 上，槽变为空
+    static void Take(TimerNode *slot, TimerNode *list)
+    {
+        list->prev = list->next = list;
+        if (slot->next == slot)
+        {
+            return;
+        }
+        list->next = slot->next;
+        list->prev = slot->prev;
+        list->next->prev = list;
+        list->prev->next = list;
+        slot->prev = slot->next = slot;
+    }
+
+    // 第 level 层的当前槽转到了，把其中的定时器重新分配到下面的层
+    void Cascade(int level)
+    {
+        TimerNode list;
+        Take(&slots[level][(current >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK], &list);
+        while (list.next != &list)
+        {
+            TimerNode *node = list.next;
+            Unlink(node);
+            Link(node);
+        }
+    }
+
+public:
+    TimerWheel() : current(NowMs() / TIMER_TICK_MS), count(0)
+    {
+        for (auto &level : slots)
+        {
+            for (auto &slot : level)
+            {
+                slot.prev = slot.next = &slot;
+            }
+        }
+    }
+
+    // 单调时钟的毫秒数，不受系统时间调整的影响
+    static uint64_t NowMs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    bool Empty()
+    {
+        return count == 0;
+    }
+
+    // 设置（或重新设置）定时器在 timeout 毫秒后到期，至少一个 tick
+    void Add(TimerNode *node, uint64_t timeout)
+    {
+        Del(node);
+        if (count == 0)
+        {
+            // 没有定时器时 reactor 会无限期等待，不会调用 Advance，先追上当前时间，否则新定时器会按过去的时间立即到期
+            uint64_t now = NowMs() / TIMER_TICK_MS;
+            current = now > current ? now : current;
+        }
+        uint64_t ticks = (timeout + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+        node->expire = current + (ticks > 0 ? ticks : 1);
+        Link(node);
+        count++;
+    }
+
+    // 取消定时器，没有设置的定时器直接忽略
+    void Del(TimerNode *node)
+    {
+        if (node->Pending())
+        {
+            Unlink(node);
+            count--;
+        }
+    }
+
+    // 推进到 now（毫秒），对每一个到期的定时器调用 on_expire(node)
+    // 回调中可以 Add/Del 任意定时器（包括同一批到期的其他定时器）
+    template <class F>
+    void Advance(uint64_t now, F on_expire)
+    {
+        uint64_t target = now / TIMER_TICK_MS;
+        if (count == 0)
+        {
+            current = target > current ? target : current;
+            return;
+        }
+        while (current < target)
+        {
+            current++;
+            // 低层转完一圈，依次把上一层的当前槽分配下来
+            for (int level = 1; level < TIMER_WHEEL_LEVELS; level++)
+            {
+                if ((current >> (TIMER_WHEEL_BITS * level - TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK)
+                {
+                    break;
+                }
+                Cascade(level);
+            }
+
+            TimerNode list;
+            Take(&slots[0][current & TIMER_WHEEL_MASK], &list);
+            while (list.next != &list)
+            {
+                TimerNode *node = list.next;
+                Unlink(node);
+                count--;
+                on_expire(node);
+            }
+        }
+    }
+};
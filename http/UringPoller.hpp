@@ -0,0 +1,304 @@
+#pragma once
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "Poller.hpp"
+
+#define URING_ENTRIES 4096     // 提交队列的大小
+#define URING_CQ_ENTRIES 65536 // 完成队列的大小：每个连接最多有一个未完成的 poll，再多由内核暂存（IORING_FEAT_NODROP）
+
+// io_uring 后端，直接使用系统调用和共享内存环形队列，不依赖 liburing
+// 连接的事件用一次性的 IORING_OP_POLL_ADD 实现，语义和 EPOLLONESHOT 相同；
+// 新连接由 multishot accept 直接交给 reactor，不需要再调用 accept4
+// reactor 线程中的 Mod 只写提交队列，在下一次 Wait 时和等待合并成一次 io_uring_enter；
+// 线程池中的 Mod 加锁写提交队列后自己提交，因为 reactor 可能正阻塞在等待中
+class UringPoller : public Poller
+{
+private:
+    // 不是连接的完成事件：EndPoint 的地址是对齐的，不会是这两个值
+    static const uint64_t ACCEPT_TAG = 1;
+    static const uint64_t REMOVE_TAG = 2;
+
+    int ring_fd;
+    int listen_sock;
+    bool multishot_accept; // 内核不支持（5.19 之前）时退回到每次完成后重新提交的 accept
+    pthread_t owner;       // reactor 线程，在 Wait 中记录
+    pthread_mutex_t lock;  // 保护提交队列，可能有多个线程同时写入
+
+    void *sq_ptr;
+    size_t sq_len;
+    void *cq_ptr;
+    size_t cq_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned sq_entries;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+private:
+    int Enter(unsigned to_submit, unsigned min_complete, unsigned flags, void *arg = nullptr, size_t argsz = 0)
+    {
+        return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, argsz);
+    }
+
+    // 提交队列中还没有交给内核的请求数
+    unsigned Pending()
+    {
+        return __atomic_load_n(sq_tail, __ATOMIC_ACQUIRE) - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    }
+
+    // 取一个空闲的提交项（调用者持有锁），队列满了先提交
+    struct io_uring_sqe *GetSqe()
+    {
+        unsigned tail = *sq_tail;
+        if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+        {
+            Enter(sq_entries, 0, 0);
+        }
+        struct io_uring_sqe *sqe = &sqes[tail & *sq_mask];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    // 填写完提交项之后发布给内核（调用者持有锁）
+    void Publish()
+    {
+        __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+    }
+
+    // 不在 reactor 线程中时立即提交，否则留到下一次 Wait
+    void SubmitIfRemote()
+    {
+        if (!pthread_equal(owner, pthread_self()))
+        {
+            Enter(Pending(), 0, 0);
+        }
+    }
+
+    void ArmAccept()
+    {
+        pthread_mutex_lock(&lock);
+        struct io_uring_sqe *sqe = GetSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listen_sock;
+        sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+        sqe->ioprio = multishot_accept ? IORING_ACCEPT_MULTISHOT : 0;
+        sqe->user_data = ACCEPT_TAG;
+        Publish();
+        pthread_mutex_unlock(&lock);
+    }
+
+    void ArmPoll(int fd, uint32_t events, void *ptr)
+    {
+        pthread_mutex_lock(&lock);
+        struct io_uring_sqe *sqe = GetSqe();
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = events;
+        sqe->user_data = (uint64_t)ptr;
+        Publish();
+        SubmitIfRemote();
+        pthread_mutex_unlock(&lock);
+    }
+
+    // 检查内核是否支持用到的操作
+    bool Probe()
+    {
+        size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+        struct io_uring_probe *probe = (struct io_uring_probe *)calloc(1, len);
+        bool ok = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+        const int ops[] = {IORING_OP_POLL_ADD, IORING_OP_POLL_REMOVE, IORING_OP_ACCEPT};
+        for (int op : ops)
+        {
+            ok = ok && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        }
+        free(probe);
+        return ok;
+    }
+
+public:
+    UringPoller()
+        : ring_fd(-1), listen_sock(-1), multishot_accept(true), owner(pthread_self()),
+          sq_ptr(MAP_FAILED), sq_len(0), cq_ptr(MAP_FAILED), cq_len(0), sqes((struct io_uring_sqe *)MAP_FAILED), sqes_len(0)
+    {
+        pthread_mutex_init(&lock, nullptr);
+    }
+
+    // 内核不支持 io_uring、被禁用或缺少需要的特性时返回 false，由 reactor 退回到 epoll
+    bool Init() override
+    {
+        struct io_uring_params p;
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = URING_CQ_ENTRIES;
+        ring_fd = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+        if (ring_fd < 0)
+        {
+            return false;
+        }
+        // 需要：等待时带超时（5.11）、完成队列不丢事件
+        if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP) || !Probe())
+        {
+            return false;
+        }
+
+        sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+        sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+        sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        sqes = (struct io_uring_sqe *)mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sq_ptr == MAP_FAILED || cq_ptr == MAP_FAILED || sqes == MAP_FAILED)
+        {
+            return false;
+        }
+
+        char *sq = (char *)sq_ptr;
+        char *cq = (char *)cq_ptr;
+        sq_head = (unsigned *)(sq + p.sq_off.head);
+        sq_tail = (unsigned *)(sq + p.sq_off.tail);
+        sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+        sq_entries = p.sq_entries;
+        cq_head = (unsigned *)(cq + p.cq_off.head);
+        cq_tail = (unsigned *)(cq + p.cq_off.tail);
+        cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+        cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+        // 提交项和下标一一对应，之后不再修改 array
+        unsigned *array = (unsigned *)(sq + p.sq_off.array);
+        for (unsigned i = 0; i < sq_entries; i++)
+        {
+            array[i] = i;
+        }
+        return true;
+    }
+
+    const char *Name() override
+    {
+        return "io_uring";
+    }
+
+    bool AddListen(int fd) override
+    {
+        listen_sock = fd;
+        ArmAccept();
+        return true;
+    }
+
+    bool Add(int fd, uint32_t events, void *ptr) override
+    {
+        ArmPoll(fd, events, ptr);
+        return true;
+    }
+
+    void Mod(int fd, uint32_t events, void *ptr) override
+    {
+        ArmPoll(fd, events, ptr);
+    }
+
+    // 还在等待的 poll 需要取消，被取消的 poll 会以 -ECANCELED 完成（或者恰好已经就绪），之后才能释放 ptr
+    bool Del(int /*fd*/, void *ptr, bool armed) override
+    {
+        if (!armed)
+        {
+            return false;
+        }
+        pthread_mutex_lock(&lock);
+        struct io_uring_sqe *sqe = GetSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)ptr;
+        sqe->user_data = REMOVE_TAG;
+        Publish();
+        pthread_mutex_unlock(&lock);
+        return true;
+    }
+
+    // 提交积累的请求并等待完成事件，合并成一次系统调用
+    int Wait(PollEvent *events, int max, int timeout) override
+    {
+        owner = pthread_self();
+        if (__atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) == *cq_head)
+        {
+            struct __kernel_timespec ts;
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (long long)(timeout % 1000) * 1000000;
+            struct io_uring_getevents_arg arg;
+            memset(&arg, 0, sizeof(arg));
+            arg.sigmask_sz = _NSIG / 8;
+            arg.ts = timeout >= 0 ? (uint64_t)&ts : 0;
+            if (Enter(Pending(), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)) < 0 && errno != ETIME)
+            {
+                return -1;
+            }
+        }
+        else if (Pending() > 0)
+        {
+            Enter(Pending(), 0, 0);
+        }
+
+        int n = 0;
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail && n < max; head++)
+        {
+            struct io_uring_cqe *cqe = &cqes[head & *cq_mask];
+            if (cqe->user_data == REMOVE_TAG)
+            {
+                continue;
+            }
+            if (cqe->user_data == ACCEPT_TAG)
+            {
+                bool more = cqe->flags & IORING_CQE_F_MORE;
+                if (cqe->res == -EINVAL && multishot_accept)
+                {
+                    multishot_accept = false;
+                }
+                else if (cqe->res >= 0)
+                {
+                    events[n++] = {nullptr, EPOLLIN, cqe->res};
+                }
+                if (!more)
+                {
+                    ArmAccept(); // multishot accept 出错时会停止，重新提交
+                }
+                continue;
+            }
+            events[n].ptr = (void *)cqe->user_data;
+            events[n].events = cqe->res < 0 ? EPOLLERR : (uint32_t)cqe->res;
+            events[n].res = -1;
+            n++;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return n;
+    }
+
+    // 关闭 io_uring 会取消所有未完成的请求
+    ~UringPoller()
+    {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqes_len);
+        if (cq_ptr != MAP_FAILED)
+            munmap(cq_ptr, cq_len);
+        if (sq_ptr != MAP_FAILED)
+            munmap(sq_ptr, sq_len);
+        if (ring_fd >= 0)
+            close(ring_fd);
+        pthread_mutex_destroy(&lock);
+    }
+};
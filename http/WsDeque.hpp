@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include "MpmcQueue.hpp"
+
+// 工作窃取用的有界双端队列（Chase-Lev，按 Lê 等人的 C11 内存序版本实现，不扩容）
+// 只有所属的线程可以在底部 Push/Take（后进先出，刚放进去的任务数据还在缓存里），
+// 其他线程在顶部 Steal（先进先出，偷走最早的任务）
+// 元素按移动存取，可以是只能移动的类型：Steal 先用 CAS 抢到位置再移走元素，
+// 每个槽有一个序号，等于 i 表示可以放入第 i 个元素；偷走的线程移走数据后才把槽还给所属的线程
+template <class T>
+class WsDeque
+{
+private:
+    struct Cell
+    {
+        std::atomic<int64_t> sequence;
+        T data;
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> top;
+    alignas(CACHE_LINE_SIZE) std::atomic<int64_t> bottom;
+    std::vector<Cell> buffer;
+    int64_t mask;
+
+    WsDeque(const WsDeque &) = delete;
+
+public:
+    // 容量向上取整到 2 的幂
+    WsDeque(size_t capacity) : top(0), bottom(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        std::vector<Cell> cells(size);
+        buffer.swap(cells);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+        {
+            buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // 当前的元素个数，并发修改时只是近似值
+    size_t Size()
+    {
+        int64_t t = top.load(std::memory_order_relaxed);
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+    // 所属线程：下一次 Push 能不能成功（只有所属线程放入元素，窃取者只会腾出位置）
+    bool CanPush()
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        return b - t <= mask && buffer[b & mask].sequence.load(std::memory_order_acquire) == b;
+    }
+
+    // 所属线程：放到底部，满了（或者上一轮偷走这个槽的线程还没有移走数据）返回 false，不会动传入的元素
+    bool Push(T &&data)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Cell &cell = buffer[b & mask];
+        if (b - t > mask || cell.sequence.load(std::memory_order_acquire) != b)
+        {
+            return false;
+        }
+        cell.data = std::move(data);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // 所属线程：从底部取出，空了返回 false
+    bool Take(T &data)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed); // 空的
+            return false;
+        }
+        if (t == b)
+        {
+            // 只剩最后一个，和窃取者竞争
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won)
+            {
+                return false;
+            }
+        }
+        Cell &cell = buffer[b & mask];
+        data = std::move(cell.data);
+        cell.sequence.store(b + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 其他线程：从顶部偷一个，空了或者和别人竞争失败返回 false
+    bool Steal(T &data)
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+        {
+            return false;
+        }
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return false;
+        }
+        Cell &cell = buffer[t & mask];
+        data = std::move(cell.data);
+        cell.sequence.store(t + mask + 1, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,27 @@
+#!/bin/bash
+# 对比 epoll 和 io_uring 两种 I/O 后端在 1k 和 10k 个并发长连接下的吞吐和延迟
+# 用法：./backend_bench.sh [连接数...，默认 1000 10000]
+# 需要先在上层目录 make 出 httpserver，在 bench 目录 make 出 http_load
+# 服务器和压测客户端各自需要比连接数更多的文件描述符（ulimit -n）
+
+PORT=${PORT:-8090}
+DURATION=${DURATION:-5}
+REACTORS=${REACTORS:-1}
+CLIENT_THREADS=${CLIENT_THREADS:-$(nproc)}
+CONNS=${@:-1000 10000}
+
+cd "$(dirname "$0")"
+ulimit -n $(ulimit -Hn)
+for c in $CONNS; do
+    for backend in epoll io_uring; do
+        # io_uring 的退出清理是异步的，监听端口可能还没释放，每一轮换一个端口
+        PORT=$((PORT + 1))
+        (cd .. && exec ./httpserver $PORT -r $REACTORS -b $backend > /dev/null 2>&1) &
+        pid=$!
+        sleep 0.5
+        echo "==== backend: $backend, conns: $c ===="
+        ./http_load -p $PORT -c $c -t $CLIENT_THREADS -d $DURATION -u /index.html -k
+        kill $pid
+        wait $pid
+    done
+done
@@ -0,0 +1,45 @@
+#!/bin/bash
+# 大输出 CGI 的三种发送方式对比：buffer（读完整个输出再发送）、splice（从管道直接发送到套接字，发完关闭连接）
+# 和 stream（边读边用分块编码发送，保持连接）；客户端都使用长连接（http_load -k）
+# CGI 程序输出指定大小的数据（默认 1 MB 和 100 MB），每种组合统计 req/s、吞吐、
+# 服务器每个响应消耗的 CPU 时间（用户态 + 内核态）和服务器的内存峰值（VmHWM）
+# 用法：./cgi_output_bench.sh [输出大小（MB）...，默认 1 100]
+# 需要先在上层目录 make 出 httpserver，在 bench 目录 make 出 http_load
+
+PORT=${PORT:-8093}
+CONNS=${CONNS:-4}
+DURATION=${DURATION:-5}
+SIZES=${@:-1 100}
+
+cd "$(dirname "$0")"
+cat > ../wwwroot/bench_output.sh << 'EOF'
+#!/bin/bash
+exec head -c "${QUERY_STRING#size=}" /dev/zero
+EOF
+chmod +x ../wwwroot/bench_output.sh
+
+# 进程累计的 CPU 时间（clock tick）
+cpu_ticks() {
+    awk '{ print $14 + $15 }' /proc/$1/stat
+}
+
+for mb in $SIZES; do
+    for mode in buffer splice stream; do
+        PORT=$((PORT + 1))
+        (cd .. && exec ./httpserver $PORT -o $mode > /dev/null 2>&1) &
+        pid=$!
+        sleep 0.5
+        echo "==== output: ${mb} MB, mode: $mode ===="
+        before=$(cpu_ticks $pid)
+        out=$(./http_load -p $PORT -c $CONNS -d $DURATION -k -u "/bench_output.sh?size=$((mb * 1024 * 1024))")
+        after=$(cpu_ticks $pid)
+        echo "$out" | tail -n +2
+        requests=$(echo "$out" | awk '/^requests:/ { print $2 }')
+        awk -v r="$requests" -v t=$((after - before)) -v hz=$(getconf CLK_TCK) -v mb=$mb -v d=$DURATION \
+            'BEGIN { if (r > 0) printf "throughput: %.0f MB/s  server cpu ms/resp: %.2f\n", r * mb / d, t * 1000 / hz / r }'
+        grep VmHWM /proc/$pid/status
+        kill $pid
+        wait $pid
+    done
+done
+rm -f ../wwwroot/bench_output.sh
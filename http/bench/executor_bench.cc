@@ -0,0 +1,218 @@
+// executor_bench：线程池普通任务接口（Post / Submit / SubmitBatch）的吞吐和每个任务的内存分配次数
+//   function：std::function 的队列（闭包捕获超过 16 字节就要分配内存），作为对照
+//   post：ThreadPool::Post，闭包放在 Job 的内联缓冲区里
+//   submit：ThreadPool::Submit，每个任务分配一次 Future 的共享状态
+//   batch：ThreadPool::SubmitBatch，每批 64 个
+// 每个闭包捕获 32 字节；分配次数通过替换全局 operator new 统计（包括线程池内部的分配）
+// 两种线程池模式（global / steal）各测一遍
+// 用法：./executor_bench [每组的任务个数，默认 1000000] [线程数，默认 4]
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../ThreadPool.hpp"
+
+#define BATCH 64
+
+static std::atomic<uint64_t> allocations(0);
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+static std::atomic<uint64_t> sum(0);
+static std::atomic<uint64_t> done(0);
+
+// 捕获 32 字节的闭包
+struct Work
+{
+    uint64_t a, b, c, d;
+    void operator()()
+    {
+        sum.fetch_add(a + b + c + d, std::memory_order_relaxed);
+        done.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+static void WaitDone(uint64_t n)
+{
+    while (done.load(std::memory_order_acquire) < n)
+    {
+        std::this_thread::yield();
+    }
+}
+
+static void Report(const char *name, uint64_t n, std::chrono::steady_clock::time_point start, uint64_t allocs)
+{
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-10s %12.0f tasks/s %8.2f allocs/task\n", name, n / secs, (double)allocs / n);
+}
+
+// 对照：互斥锁保护的 std::function 队列，和原来的 ThreadPool 一样
+static void RunFunction(uint64_t n, int threads)
+{
+    std::vector<std::function<void()>> q;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+    bool stop = false;
+    q.reserve(n);
+    size_t head = 0;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        workers.emplace_back([&] {
+            for (;;)
+            {
+                pthread_mutex_lock(&lock);
+                while (head == q.size() && !stop)
+                {
+                    pthread_cond_wait(&cond, &lock);
+                }
+                if (head == q.size())
+                {
+                    pthread_mutex_unlock(&lock);
+                    return;
+                }
+                std::function<void()> f = std::move(q[head++]);
+                pthread_mutex_unlock(&lock);
+                f();
+            }
+        });
+    }
+    done = 0;
+    uint64_t before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        std::function<void()> f = Work{i, 1, 2, 3};
+        pthread_mutex_lock(&lock);
+        q.push_back(std::move(f));
+        pthread_mutex_unlock(&lock);
+        pthread_cond_signal(&cond);
+    }
+    WaitDone(n);
+    Report("function", n, start, allocations.load() - before);
+    pthread_mutex_lock(&lock);
+    stop = true;
+    pthread_mutex_unlock(&lock);
+    pthread_cond_broadcast(&cond);
+    for (auto &t : workers)
+    {
+        t.join();
+    }
+}
+
+static void RunPool(ThreadPool *tp, uint64_t n)
+{
+    // post
+    done = 0;
+    uint64_t before = allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n; i++)
+    {
+        while (!tp->Post(Work{i, 1, 2, 3}))
+        {
+            std::this_thread::yield();
+        }
+    }
+    WaitDone(n);
+    Report("post", n, start, allocations.load() - before);
+
+    // submit：每 BATCH 个等一次结果，Future 不会一直积累
+    done = 0;
+    before = allocations.load();
+    start = std::chrono::steady_clock::now();
+    std::vector<Future<uint64_t>> futures;
+    futures.reserve(BATCH);
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < n; i++)
+    {
+        Future<uint64_t> f = tp->Submit([i] { return i; });
+        while (!f.Valid())
+        {
+            std::this_thread::yield();
+            f = tp->Submit([i] { return i; });
+        }
+        futures.push_back(std::move(f));
+        if (futures.size() == BATCH)
+        {
+            for (auto &f : futures)
+            {
+                total += f.Get();
+            }
+            futures.clear();
+        }
+    }
+    for (auto &f : futures)
+    {
+        total += f.Get();
+    }
+    futures.clear();
+    Report("submit", n, start, allocations.load() - before);
+    if (total != n * (n - 1) / 2)
+    {
+        printf("submit: wrong sum %lu\n", (unsigned long)total);
+    }
+
+    // batch
+    done = 0;
+    std::vector<Job> jobs;
+    jobs.reserve(BATCH);
+    before = allocations.load();
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < n;)
+    {
+        while (jobs.size() < BATCH && i < n)
+        {
+            jobs.emplace_back(Work{i++, 1, 2, 3});
+        }
+        while (tp->SubmitBatch(jobs) == 0 && !jobs.empty())
+        {
+            std::this_thread::yield();
+        }
+    }
+    while (!jobs.empty())
+    {
+        tp->SubmitBatch(jobs);
+    }
+    WaitDone(n);
+    Report("batch", n, start, allocations.load() - before);
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    int threads = argc > 2 ? atoi(argv[2]) : 4;
+    printf("%lu tasks, %d threads, %zu-byte closures\n", (unsigned long)n, threads, sizeof(Work));
+
+    RunFunction(n, threads);
+    // 每种模式一个线程池（POOL_STATIC 和 POOL_CGI 两个实例，只是借用它们的位置）
+    printf("-- global\n");
+    RunPool(ThreadPool::getinstance(POOL_STATIC, TASK_QUEUE_CAPACITY, POOL_GLOBAL, threads, threads), n);
+    printf("-- steal\n");
+    RunPool(ThreadPool::getinstance(POOL_CGI, TASK_QUEUE_CAPACITY, POOL_STEAL, threads, threads), n);
+    return 0;
+}
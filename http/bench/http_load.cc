@@ -0,0 +1,380 @@
+// http_load：简单的 HTTP 压测客户端
+// 每个线程用一个 epoll 模型维护 -c/-t 个并发连接；
+// 每个连接：connect -> 发送请求 -> 读到对端关闭（HTTP/1.0 短连接）-> 重新 connect
+// -k：使用 HTTP/1.1 长连接，按 Content-Length（或分块编码的结束块）读完一个响应后在同一连接上发送下一个请求
+// 关闭连接前通过 TCP_INFO 取得收到的数据段个数，统计平均每个响应占用的 TCP 数据段（packets/resp），
+// 以及按以太网 + IPv4 + TCP（带时间戳选项）每段 66 字节首部估算的线上字节数（wire bytes/resp）
+// 用法：./http_load -p 8081 -c 256 -t 4 -d 5 -u /index.html [-k]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+#include <arpa/inet.h>
+
+struct Options
+{
+    std::string ip;
+    int port;
+    int conns;    // 总并发连接数
+    int threads;  // 客户端线程数
+    int duration; // 压测时长（秒）
+    std::string url;
+    bool keep_alive; // 是否使用长连接
+};
+
+// 单个连接的状态
+struct Conn
+{
+    int fd;
+    size_t sent;       // 请求已发送的字节数
+    uint64_t start_us; // 本次请求开始的时间
+    size_t rbytes;     // 本次响应收到的字节数
+    size_t expect;     // 长连接：本次响应的总长度（响应头 + Content-Length），0 表示还没收到完整的响应头
+    std::string head;  // 长连接：正在接收的响应头
+    bool chunked;      // 长连接：响应使用分块编码，以结束块（和它后面的空行）表示响应结束
+    bool last_chunk;   // 已经收到结束块，还差最后的空行
+    size_t chunk_left; // 当前块还没收到的字节数（包括块尾的 CRLF）
+    std::string chunk_line; // 正在接收的块头（或结束块后面的行）
+    uint64_t responses; // 这个连接上完成的响应数
+};
+
+// 每个线程的统计结果
+struct Stat
+{
+    uint64_t done;    // 完成的请求（连接）数
+    uint64_t errors;  // 失败的连接数
+    uint64_t bytes;   // 收到的字节数
+    uint64_t segs;    // 收到的 TCP 数据段数（只统计完成的响应所在的连接）
+    uint64_t seg_responses; // segs 对应的响应数
+    uint64_t seg_bytes;     // segs 对应的响应字节数
+    std::vector<uint32_t> latency_us;
+};
+
+struct Worker
+{
+    Options *opt;
+    int conns;
+    Stat stat;
+};
+
+static uint64_t NowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static bool Open(Options *opt, int epfd, Conn *c)
+{
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c->fd < 0)
+        return false;
+    struct sockaddr_in peer;
+    memset(&peer, 0, sizeof(peer));
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(opt->port);
+    inet_pton(AF_INET, opt->ip.c_str(), &peer.sin_addr);
+    c->sent = 0;
+    c->rbytes = 0;
+    c->expect = 0;
+    c->head.clear();
+    c->chunked = false;
+    c->last_chunk = false;
+    c->chunk_left = 0;
+    c->chunk_line.clear();
+    c->responses = 0;
+    c->start_us = NowUs();
+    if (connect(c->fd, (struct sockaddr *)&peer, sizeof(peer)) < 0 && errno != EINPROGRESS)
+    {
+        close(c->fd);
+        return false;
+    }
+    struct epoll_event ev;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+    return true;
+}
+
+// 关闭连接，记录这个连接上收到的 TCP 数据段数
+static void Close(Stat &stat, Conn *c)
+{
+    struct tcp_info info;
+    socklen_t len = sizeof(info);
+    if (c->responses > 0 && getsockopt(c->fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0)
+    {
+        stat.segs += info.tcpi_data_segs_in;
+        stat.seg_responses += c->responses;
+        stat.seg_bytes += info.tcpi_bytes_received;
+    }
+    close(c->fd);
+}
+
+// 长连接：解析响应头中的 Content-Length，得到整个响应的长度；分块编码的响应长度未知，由 ParseChunks 判断结束，
+// 两者都没有的响应以服务器关闭连接表示结束
+// 返回正文在 data 中开始的位置（响应头还没收完时返回 len）
+static size_t ParseHead(Conn *c, const char *data, size_t len)
+{
+    if (c->expect > 0)
+        return 0;
+    size_t old = c->head.size();
+    c->head.append(data, std::min(len, (size_t)8192));
+    size_t pos = c->head.find("\r\n\r\n");
+    if (pos == std::string::npos)
+        return len;
+    size_t content_length = (size_t)-1;
+    for (size_t i = 0; i < pos; i++)
+    {
+        if (strncasecmp(c->head.c_str() + i, "\nContent-Length:", 16) == 0)
+        {
+            content_length = strtoul(c->head.c_str() + i + 16, nullptr, 10);
+            break;
+        }
+        if (strncasecmp(c->head.c_str() + i, "\nTransfer-Encoding: chunked", 27) == 0)
+        {
+            c->chunked = true;
+            break;
+        }
+    }
+    c->expect = c->chunked || content_length == (size_t)-1 ? (size_t)-1 : pos + 4 + content_length;
+    return pos + 4 - old;
+}
+
+// 分块编码：跳过每块的数据，只解析块头；收到结束块和它后面的空行（不带 trailer）返回 true
+static bool ParseChunks(Conn *c, const char *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len)
+    {
+        if (c->chunk_left > 0)
+        {
+            size_t n = std::min(c->chunk_left, len - i);
+            c->chunk_left -= n;
+            i += n;
+            continue;
+        }
+        const char *eol = (const char *)memchr(data + i, '\n', len - i);
+        size_t end = eol == nullptr ? len : eol - data + 1;
+        c->chunk_line.append(data + i, end - i);
+        i = end;
+        if (eol == nullptr)
+            break;
+        if (c->last_chunk)
+        {
+            if (c->chunk_line == "\r\n")
+                return true;
+        }
+        else
+        {
+            size_t size = strtoul(c->chunk_line.c_str(), nullptr, 16);
+            if (size == 0)
+                c->last_chunk = true;
+            else
+                c->chunk_left = size + 2;
+        }
+        c->chunk_line.clear();
+    }
+    return false;
+}
+
+static void *Run(void *args)
+{
+    Worker *w = (Worker *)args;
+    Options *opt = w->opt;
+    std::string request = "GET " + opt->url + (opt->keep_alive ? " HTTP/1.1" : " HTTP/1.0") + "\r\nHost: " + opt->ip + "\r\nUser-Agent: http_load\r\n\r\n";
+
+    int epfd = epoll_create1(0);
+    std::vector<Conn> conns(w->conns);
+    for (auto &c : conns)
+    {
+        while (!Open(opt, epfd, &c))
+            w->stat.errors++;
+    }
+
+    uint64_t deadline = NowUs() + (uint64_t)opt->duration * 1000000;
+    struct epoll_event events[256];
+    char buffer[65536];
+    while (NowUs() < deadline)
+    {
+        int n = epoll_wait(epfd, events, 256, 100);
+        for (int i = 0; i < n; i++)
+        {
+            Conn *c = (Conn *)events[i].data.ptr;
+            bool finish = false, fail = false, reopen = true;
+            if (events[i].events & EPOLLOUT)
+            {
+                ssize_t s = send(c->fd, request.c_str() + c->sent, request.size() - c->sent, 0);
+                if (s > 0)
+                {
+                    c->sent += s;
+                    if (c->sent == request.size())
+                    {
+                        struct epoll_event ev;
+                        ev.events = EPOLLIN;
+                        ev.data.ptr = c;
+                        epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+                    }
+                }
+                else if (errno != EAGAIN)
+                {
+                    fail = true;
+                }
+            }
+            else if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                while (true)
+                {
+                    ssize_t s = recv(c->fd, buffer, sizeof(buffer), 0);
+                    if (s > 0)
+                    {
+                        bool chunks_done = false;
+                        if (opt->keep_alive)
+                        {
+                            size_t body = ParseHead(c, buffer, s);
+                            chunks_done = c->chunked && ParseChunks(c, buffer + body, s - body);
+                        }
+                        c->rbytes += s;
+                        if (chunks_done || (c->expect > 0 && c->rbytes >= c->expect))
+                        {
+                            finish = true;
+                            reopen = strcasestr(c->head.c_str(), "\nConnection: close") != nullptr; // 服务器要关闭连接
+                            break;
+                        }
+                        continue;
+                    }
+                    if (s == 0)
+                        finish = c->rbytes > 0;
+                    if (s == 0 && c->rbytes == 0)
+                        fail = true;
+                    if (s < 0 && errno != EAGAIN)
+                        fail = true;
+                    break;
+                }
+            }
+            if (finish || fail)
+            {
+                if (finish)
+                {
+                    w->stat.done++;
+                    w->stat.bytes += c->rbytes;
+                    w->stat.latency_us.push_back((uint32_t)(NowUs() - c->start_us));
+                    c->responses++;
+                }
+                else
+                {
+                    w->stat.errors++;
+                }
+                if (finish && !reopen)
+                {
+                    // 长连接：在同一个连接上发送下一个请求
+                    c->sent = 0;
+                    c->rbytes = 0;
+                    c->expect = 0;
+                    c->head.clear();
+                    c->chunked = false;
+                    c->last_chunk = false;
+                    c->chunk_left = 0;
+                    c->chunk_line.clear();
+                    c->start_us = NowUs();
+                    struct epoll_event ev;
+                    ev.events = EPOLLOUT;
+                    ev.data.ptr = c;
+                    epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+                    continue;
+                }
+                Close(w->stat, c);
+                while (!Open(opt, epfd, c))
+                    w->stat.errors++;
+            }
+        }
+    }
+    for (auto &c : conns)
+        Close(w->stat, &c);
+    close(epfd);
+    return nullptr;
+}
+
+static void Usage(const char *proc)
+{
+    std::cout << "Usage:\n\t" << proc << " [-i ip] [-p port] [-c conns] [-t threads] [-d seconds] [-u url] [-k]" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    Options opt = {"127.0.0.1", 8081, 64, 1, 5, "/", false};
+    int ch = 0;
+    while ((ch = getopt(argc, argv, "i:p:c:t:d:u:k")) != -1)
+    {
+        switch (ch)
+        {
+        case 'i': opt.ip = optarg; break;
+        case 'p': opt.port = atoi(optarg); break;
+        case 'c': opt.conns = atoi(optarg); break;
+        case 't': opt.threads = atoi(optarg); break;
+        case 'd': opt.duration = atoi(optarg); break;
+        case 'u': opt.url = optarg; break;
+        case 'k': opt.keep_alive = true; break;
+        default: Usage(argv[0]); return 1;
+        }
+    }
+    if (opt.threads <= 0 || opt.conns < opt.threads)
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Worker> workers(opt.threads);
+    std::vector<pthread_t> tids(opt.threads);
+    for (int i = 0; i < opt.threads; i++)
+    {
+        workers[i].opt = &opt;
+        workers[i].conns = opt.conns / opt.threads + (i < opt.conns % opt.threads ? 1 : 0);
+        workers[i].stat = Stat();
+        pthread_create(&tids[i], nullptr, Run, &workers[i]);
+    }
+
+    Stat total = Stat();
+    for (int i = 0; i < opt.threads; i++)
+    {
+        pthread_join(tids[i], nullptr);
+        total.done += workers[i].stat.done;
+        total.errors += workers[i].stat.errors;
+        total.bytes += workers[i].stat.bytes;
+        total.segs += workers[i].stat.segs;
+        total.seg_responses += workers[i].stat.seg_responses;
+        total.seg_bytes += workers[i].stat.seg_bytes;
+        total.latency_us.insert(total.latency_us.end(), workers[i].stat.latency_us.begin(), workers[i].stat.latency_us.end());
+    }
+    std::sort(total.latency_us.begin(), total.latency_us.end());
+    auto pct = [&](double p) -> double {
+        if (total.latency_us.empty())
+            return 0;
+        size_t idx = std::min(total.latency_us.size() - 1, (size_t)(p * total.latency_us.size()));
+        return total.latency_us[idx] / 1000.0;
+    };
+
+    printf("conns=%d threads=%d duration=%ds url=%s %s\n", opt.conns, opt.threads, opt.duration, opt.url.c_str(),
+           opt.keep_alive ? "keep-alive" : "close");
+    printf("requests: %lu  errors: %lu  req/s: %.0f  bytes/resp: %.0f\n",
+           (unsigned long)total.done, (unsigned long)total.errors,
+           (double)total.done / opt.duration,
+           total.done ? (double)total.bytes / total.done : 0.0);
+    double resps = total.seg_responses ? (double)total.seg_responses : 1.0;
+    printf("packets/resp: %.2f  wire bytes/resp: %.0f\n", total.segs / resps,
+           (total.seg_bytes + total.segs * 66) / resps);
+    printf("latency ms: p50 %.3f  p99 %.3f  max %.3f\n", pct(0.50), pct(0.99), pct(1.0));
+    return 0;
+}
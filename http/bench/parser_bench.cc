@@ -0,0 +1,157 @@
+// parser_bench：对比请求头解析的两种实现
+//   old：逐行拷贝到 std::string，stringstream 拆请求行，CutString 拆出 key/value 存入 unordered_map（原先的实现）
+//   new：HttpParser 在缓冲区上直接生成 string_view
+// 输出每个请求的平均耗时和平均内存申请次数
+// 用法：./parser_bench [迭代次数]
+
+#include <iostream>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "../HttpParser.hpp"
+
+static size_t alloc_count = 0;
+
+void *operator new(size_t size)
+{
+    alloc_count++;
+    void *p = malloc(size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// 浏览器发出的典型请求头
+static const char *kRequest =
+    "GET /static/css/main.css?v=20240101 HTTP/1.1\r\n"
+    "Host: www.example.com\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+    "sec-ch-ua-platform: \"Linux\"\r\n"
+    "Accept: text/css,*/*;q=0.1\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: no-cors\r\n"
+    "Sec-Fetch-Dest: style\r\n"
+    "Referer: https://www.example.com/index.html\r\n"
+    "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Cookie: session=2f1c9a7e5b3d4c6a8e0f1b2d3c4e5f6a; theme=dark; lang=zh-CN\r\n"
+    "\r\n";
+
+// 原先的实现：按行取出（"\r\n"、"\n"、单独的 "\r" 都转换为 "\n"）
+static bool OldGetLine(const char *&p, const char *end, std::string &out)
+{
+    for (const char *q = p; q < end; q++)
+    {
+        if (*q == '\n' || *q == '\r')
+        {
+            out.append(p, q - p);
+            out.push_back('\n');
+            p = q + ((*q == '\r' && q + 1 < end && q[1] == '\n') ? 2 : 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool CutString(const std::string &target, std::string &sub1_out, std::string &sub2_out, std::string sep)
+{
+    size_t pos = target.find(sep);
+    if (pos != std::string::npos)
+    {
+        sub1_out = target.substr(0, pos);
+        sub2_out = target.substr(pos + sep.size());
+        return true;
+    }
+    return false;
+}
+
+struct OldRequest
+{
+    std::string request_line;
+    std::vector<std::string> request_header;
+    std::string method, uri, version;
+    std::unordered_map<std::string, std::string> header_kv;
+};
+
+static size_t OldParse(const char *data, size_t len)
+{
+    OldRequest req;
+    const char *p = data, *end = data + len;
+    OldGetLine(p, end, req.request_line);
+    req.request_line.resize(req.request_line.size() - 1);
+    std::string line;
+    while (true)
+    {
+        line.clear();
+        if (!OldGetLine(p, end, line) || line == "\n")
+            break;
+        line.resize(line.size() - 1);
+        req.request_header.push_back(line);
+    }
+    std::stringstream ss(req.request_line);
+    ss >> req.method >> req.uri >> req.version;
+    std::transform(req.method.begin(), req.method.end(), req.method.begin(), ::toupper);
+    std::string key, value;
+    for (auto &iter : req.request_header)
+    {
+        if (CutString(iter, key, value, ": "))
+            req.header_kv.insert({key, value});
+    }
+    return req.header_kv.size() + req.uri.size();
+}
+
+static size_t NewParse(HttpParser &parser, HttpRequestHead &head, const char *data, size_t len)
+{
+    head.ClearHead();
+    parser.Reset();
+    parser.Parse(data, len, head);
+    return head.header_kv.size() + head.uri.size();
+}
+
+template <typename F>
+static void Run(const char *name, int iters, F f)
+{
+    size_t sink = 0;
+    size_t allocs = alloc_count;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++)
+        sink += f();
+    auto cost = std::chrono::steady_clock::now() - start;
+    allocs = alloc_count - allocs;
+    double ns = std::chrono::duration<double, std::nano>(cost).count() / iters;
+    printf("%-4s %8.1f ns/request  %6.2f allocs/request  (%zu)\n", name, ns, (double)allocs / iters, sink % 10);
+}
+
+int main(int argc, char *argv[])
+{
+    int iters = argc > 1 ? atoi(argv[1]) : 200000;
+    std::string request = kRequest;
+    printf("request head: %zu bytes, %d iterations\n", request.size(), iters);
+
+    HttpParser parser;
+    HttpRequestHead head;
+    NewParse(parser, head, request.data(), request.size()); // 预热，让 vector 分配好空间
+
+    Run("old", iters, [&]() { return OldParse(request.data(), request.size()); });
+    Run("new", iters, [&]() { return NewParse(parser, head, request.data(), request.size()); });
+    return 0;
+}
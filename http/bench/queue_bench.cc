@@ -0,0 +1,141 @@
+// queue_bench：对比线程池任务队列的两种实现在不同线程数下的吞吐
+//   mutex：std::queue + 互斥锁 + 条件变量，每次入队都 pthread_cond_signal（原来的 ThreadPool）
+//   mpmc：无锁有界队列 MpmcQueue + EventCount，只有消费者确实在睡眠时才唤醒（现在的 ThreadPool）
+// 生产者和消费者线程数相同，从 1 到 64 翻倍；消费者取完全部数据后统计每秒出队数
+// 有界队列的容量和 ThreadPool 默认的 TASK_QUEUE_CAPACITY 相同
+// 用法：./queue_bench [每组的数据个数，默认 1000000] [最大线程数，默认 64]
+
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+#include <pthread.h>
+#include "../MpmcQueue.hpp"
+
+#define CAPACITY 65536 // 与 TASK_QUEUE_CAPACITY 相同
+#define STOP UINT64_MAX // 让消费者退出的数据
+
+struct MutexQueue
+{
+    std::queue<uint64_t> q;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+    void Push(uint64_t v)
+    {
+        pthread_mutex_lock(&lock);
+        q.push(v);
+        pthread_mutex_unlock(&lock);
+        pthread_cond_signal(&cond);
+    }
+
+    uint64_t Pop()
+    {
+        pthread_mutex_lock(&lock);
+        while (q.empty())
+        {
+            pthread_cond_wait(&cond, &lock);
+        }
+        uint64_t v = q.front();
+        q.pop();
+        pthread_mutex_unlock(&lock);
+        return v;
+    }
+};
+
+struct LockFreeQueue
+{
+    MpmcQueue<uint64_t> q{CAPACITY};
+    EventCount idle;
+
+    void Push(uint64_t v)
+    {
+        while (!q.TryPush(v))
+        {
+            std::this_thread::yield(); // 队列满了，等消费者取走
+        }
+        idle.Notify();
+    }
+
+    uint64_t Pop()
+    {
+        uint64_t v;
+        while (!q.TryPop(v))
+        {
+            uint32_t key = idle.PrepareWait();
+            if (q.TryPop(v))
+            {
+                idle.CancelWait();
+                break;
+            }
+            idle.Wait(key);
+        }
+        return v;
+    }
+};
+
+template <class Q>
+static double Run(Q &q, int threads, uint64_t items, uint64_t &sum)
+{
+    std::atomic<uint64_t> total{0};
+    std::vector<std::thread> consumers, producers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; i++)
+    {
+        consumers.emplace_back([&] {
+            uint64_t s = 0;
+            for (uint64_t v; (v = q.Pop()) != STOP;)
+            {
+                s += v;
+            }
+            total.fetch_add(s);
+        });
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        producers.emplace_back([&, i] {
+            for (uint64_t v = i; v < items; v += threads)
+            {
+                q.Push(v);
+            }
+        });
+    }
+    for (auto &t : producers)
+        t.join();
+    for (int i = 0; i < threads; i++)
+        q.Push(STOP);
+    for (auto &t : consumers)
+        t.join();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    sum = total.load();
+    return items / sec;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t items = argc > 1 ? atoll(argv[1]) : 1000000;
+    int max_threads = argc > 2 ? atoi(argv[2]) : 64;
+    uint64_t expect = items * (items - 1) / 2;
+
+    printf("items: %llu, cpus: %u\n", (unsigned long long)items, std::thread::hardware_concurrency());
+    printf("%8s %14s %14s %10s\n", "threads", "mutex ops/s", "mpmc ops/s", "speedup");
+    for (int n = 1; n <= max_threads; n *= 2)
+    {
+        uint64_t s1 = 0, s2 = 0;
+        MutexQueue mq;
+        double a = Run(mq, n, items, s1);
+        LockFreeQueue lq;
+        double b = Run(lq, n, items, s2);
+        if (s1 != expect || s2 != expect)
+        {
+            printf("checksum mismatch at %d threads\n", n);
+            return 1;
+        }
+        printf("%8d %14.0f %14.0f %9.2fx\n", n, a, b, b / a);
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+#!/bin/bash
+# 对比不同 reactor 个数下服务器每秒能建立（并处理完）的短连接数
+# 用法：./reactor_bench.sh [最大 reactor 数，默认 CPU 个数]
+# 需要先在上层目录 make 出 httpserver，在 bench 目录 make 出 http_load
+
+PORT=${PORT:-8090}
+CONNS=${CONNS:-256}
+DURATION=${DURATION:-5}
+MAX=${1:-$(nproc)}
+CLIENT_THREADS=${CLIENT_THREADS:-$(nproc)}
+
+cd "$(dirname "$0")"
+r=1
+while [ $r -le $MAX ]; do
+    (cd .. && exec ./httpserver $PORT -r $r > /dev/null 2>&1) &
+    pid=$!
+    sleep 0.5
+    echo "==== reactors: $r ===="
+    ./http_load -p $PORT -c $CONNS -t $CLIENT_THREADS -d $DURATION -u /index.html
+    kill $pid
+    wait $pid
+    r=$((r * 2))
+done
@@ -0,0 +1,167 @@
+// scan_bench：对比分隔符扫描函数的标量、SSE2、AVX2 实现
+//   先用随机数据检查各实现的结果与标量实现完全一致
+//   再用 400B ~ 4KB 的浏览器请求头测量：
+//     scan：只做分隔符扫描（逐行查找行尾，每个报头行查找 ':'）
+//     parse：HttpParser 完整解析请求头
+// 用法：./scan_bench [迭代次数]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include "../HttpParser.hpp"
+
+static const char *kKernels[] = {"scalar", "sse2", "avx2"};
+
+// 浏览器发出的典型请求头，Cookie 和附加报头的长度决定请求头的总大小
+static std::string MakeRequest(size_t target)
+{
+    std::string req =
+        "GET /static/js/app.bundle.js?v=20240101&lang=zh-CN HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+        "Accept: */*\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "Referer: https://www.example.com/\r\n";
+    const char *extra[] = {
+        "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n",
+        "sec-ch-ua-mobile: ?0\r\n",
+        "sec-ch-ua-platform: \"Linux\"\r\n",
+        "Sec-Fetch-Site: same-origin\r\n",
+        "Sec-Fetch-Mode: no-cors\r\n",
+        "Sec-Fetch-Dest: script\r\n",
+        "Cache-Control: max-age=0\r\n",
+        "If-None-Match: W/\"5e1d-18c2a7f3b40\"\r\n",
+        "If-Modified-Since: Mon, 01 Jan 2024 00:00:00 GMT\r\n",
+        "Upgrade-Insecure-Requests: 1\r\n",
+    };
+    for (size_t i = 0; i < sizeof(extra) / sizeof(extra[0]) && req.size() + 2 < target; i++)
+    {
+        req += extra[i];
+    }
+    // 剩余的长度用 Cookie 填满（大请求头通常就是 Cookie 造成的）
+    if (req.size() + 16 < target)
+    {
+        std::string cookie = "Cookie: ";
+        std::mt19937 rng(target);
+        const char *hex = "0123456789abcdef";
+        int n = 0;
+        while (req.size() + cookie.size() + 4 < target)
+        {
+            if (n > 0)
+                cookie += "; ";
+            cookie += "ck" + std::to_string(n++) + "=";
+            for (int i = 0; i < 32; i++)
+                cookie += hex[rng() % 16];
+        }
+        req += cookie + "\r\n";
+    }
+    req += "\r\n";
+    return req;
+}
+
+// 随机数据上比较各实现与标量实现的结果：覆盖不同的长度、起始对齐和分隔符密度
+static bool Check()
+{
+    std::mt19937 rng(12345);
+    std::vector<char> buf(4096 + 64);
+    for (int round = 0; round < 20000; round++)
+    {
+        int density = 1 + rng() % 200;
+        for (auto &c : buf)
+        {
+            unsigned r = rng() % density;
+            c = r == 0 ? '\r' : r == 1 ? '\n' : r == 2 ? ':' : r == 3 ? '.' : (char)('a' + rng() % 26);
+        }
+        size_t off = rng() % 64;
+        size_t len = rng() % (round % 10 == 0 ? 4096 : 100);
+        const char *p = buf.data() + off, *end = p + len;
+
+        Scan::Select("scalar");
+        const char *e1 = Scan::FindLineEnd(p, end);
+        const char *e2 = Scan::FindChar(p, end, ':');
+        const char *e3 = Scan::FindLastChar(p, end, '.');
+        for (const char *name : kKernels)
+        {
+            if (!Scan::Select(name))
+                continue;
+            if (Scan::FindLineEnd(p, end) != e1 || Scan::FindChar(p, end, ':') != e2 || Scan::FindLastChar(p, end, '.') != e3)
+            {
+                printf("mismatch: kernel %s, offset %zu, length %zu\n", name, off, len);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 只做分隔符扫描：与 HttpParser 相同的方式逐行查找行尾，再在每行中查找 ':'
+static size_t ScanOnly(const char *data, size_t len)
+{
+    const char *p = data, *end = data + len;
+    size_t sink = 0;
+    while (p < end)
+    {
+        const char *eol = Scan::FindLineEnd(p, end);
+        sink += Scan::FindChar(p, eol, ':') - p;
+        p = eol + 1;
+    }
+    return sink;
+}
+
+static size_t Parse(HttpParser &parser, HttpRequestHead &head, const char *data, size_t len)
+{
+    head.ClearHead();
+    parser.Reset();
+    parser.Parse(data, len, head);
+    return head.header_kv.size() + head.uri.size();
+}
+
+template <typename F>
+static double Run(int iters, F f)
+{
+    size_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; i++)
+        sink += f();
+    auto cost = std::chrono::steady_clock::now() - start;
+    if (sink == 1)
+        printf(" ");
+    return std::chrono::duration<double, std::nano>(cost).count() / iters;
+}
+
+int main(int argc, char *argv[])
+{
+    int iters = argc > 1 ? atoi(argv[1]) : 200000;
+    printf("detected kernel: %s\n", Scan::KernelName());
+    if (!Check())
+    {
+        return 1;
+    }
+    printf("check: all kernels match scalar\n\n");
+
+    printf("%-6s %-7s %10s %10s %10s\n", "bytes", "kernel", "scan(ns)", "GB/s", "parse(ns)");
+    size_t sizes[] = {400, 1024, 2048, 4096};
+    for (size_t target : sizes)
+    {
+        std::string request = MakeRequest(target);
+        for (const char *name : kKernels)
+        {
+            if (!Scan::Select(name))
+                continue;
+            HttpParser parser;
+            HttpRequestHead head;
+            Parse(parser, head, request.data(), request.size()); // 预热，让 vector 分配好空间
+
+            double scan = Run(iters, [&]() { return ScanOnly(request.data(), request.size()); });
+            double parse = Run(iters, [&]() { return Parse(parser, head, request.data(), request.size()); });
+            printf("%-6zu %-7s %10.1f %10.2f %10.1f\n", request.size(), name, scan, request.size() / scan, parse);
+        }
+    }
+    return 0;
+}
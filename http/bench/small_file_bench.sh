@@ -0,0 +1,27 @@
+#!/bin/bash
+# 小文件（1KB ~ 16KB 的静态资源）压测：每种大小分别统计 req/s、每个响应的 TCP 报文段数和线上字节数
+# 用法：./small_file_bench.sh [服务器程序，默认 ../httpserver]
+# 需要先在上层目录 make 出 httpserver，在 bench 目录 make 出 http_load
+# KEEPALIVE=0 时使用短连接（HTTP/1.0），默认使用长连接
+
+PORT=${PORT:-8091}
+CONNS=${CONNS:-32}
+DURATION=${DURATION:-5}
+KEEPALIVE=${KEEPALIVE:-1}
+SERVER=$(realpath "${1:-../httpserver}" 2>/dev/null || realpath "$(dirname "$0")/../httpserver")
+
+cd "$(dirname "$0")"
+KFLAG=""
+[ "$KEEPALIVE" = "1" ] && KFLAG="-k"
+
+(cd .. && exec "$SERVER" $PORT > /dev/null 2>&1) &
+pid=$!
+sleep 0.5
+for kb in 1 2 4 8 16; do
+    head -c $((kb * 1024)) /dev/urandom > ../wwwroot/bench_${kb}k.bin
+    echo "==== ${kb} KB ===="
+    ./http_load -p $PORT -c $CONNS -d $DURATION -u /bench_${kb}k.bin $KFLAG | tail -n +2
+    rm -f ../wwwroot/bench_${kb}k.bin
+done
+kill $pid
+wait $pid
@@ -0,0 +1,125 @@
+// spawn_bench：启动 CGI 程序的延迟和服务器进程大小（RSS）的关系
+//   fork：fork + 子进程里 dup2/execve（原来的 ProcessCgi），要复制整个进程的页表
+//   spawn：Spawn::Run（posix_spawn，子进程共享地址空间，close_range 关闭其余描述符），和进程大小无关
+// 每一组先把进程的 RSS 增加到指定大小（分配并写入内存），再各启动若干次 /bin/true 并等它退出，
+// 统计从开始启动到 waitpid 返回的平均时间；进程还打开了 1000 个描述符，模拟服务器上的连接
+// 用法：./spawn_bench [每组的次数，默认 200] [最大的 RSS（MB），默认 2048]
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "../Spawn.hpp"
+
+#define PROGRAM "/bin/true"
+#define OPEN_FDS 1000
+
+static long RssMb()
+{
+    long pages = 0, rss = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f != nullptr)
+    {
+        if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+        {
+            rss = 0;
+        }
+        fclose(f);
+    }
+    return rss * sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+// 和原来的 ProcessCgi 一样：fork，子进程重定向到管道后 exec
+static pid_t ForkExec(const std::vector<std::string> &env, int in_fd, int out_fd)
+{
+    std::vector<char *> envp;
+    for (auto &var : env)
+    {
+        envp.push_back((char *)var.c_str());
+    }
+    envp.push_back(nullptr);
+    char *argv[] = {(char *)PROGRAM, nullptr};
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(in_fd, 0);
+        dup2(out_fd, 1);
+        execve(PROGRAM, argv, envp.data());
+        _exit(127);
+    }
+    return pid;
+}
+
+static double Measure(bool use_spawn, int rounds)
+{
+    std::vector<std::string> env = Spawn::BuildEnv({"METHOD=GET", "QUERY_STRING=a=1&b=2"});
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++)
+    {
+        int input[2], output[2];
+        if (pipe2(input, O_CLOEXEC) < 0 || pipe2(output, O_CLOEXEC) < 0)
+        {
+            perror("pipe");
+            exit(1);
+        }
+        pid_t pid = use_spawn ? Spawn::Run(PROGRAM, env, output[0], input[1]) : ForkExec(env, output[0], input[1]);
+        close(input[1]);
+        close(output[0]);
+        if (pid < 0)
+        {
+            perror("spawn");
+            exit(1);
+        }
+        char buf[64];
+        while (read(input[0], buf, sizeof(buf)) > 0)
+        {
+        }
+        waitpid(pid, nullptr, 0);
+        close(input[0]);
+        close(output[1]);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 200;
+    long max_mb = argc > 2 ? atol(argv[2]) : 2048;
+
+    for (int i = 0; i < OPEN_FDS; i++)
+    {
+        if (open("/dev/null", O_RDONLY) < 0) // 故意不设 O_CLOEXEC，和服务器的连接一样
+        {
+            break;
+        }
+    }
+
+    printf("%-10s %12s %12s\n", "rss_mb", "fork_us", "spawn_us");
+    std::vector<char *> blocks;
+    for (long target = 0; target <= max_mb; target = target == 0 ? 256 : target * 2)
+    {
+        while (RssMb() < target)
+        {
+            size_t size = 64 << 20;
+            char *p = (char *)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+            {
+                perror("mmap");
+                return 1;
+            }
+            memset(p, 1, size);
+            blocks.push_back(p);
+        }
+        double fork_us = Measure(false, rounds);
+        double spawn_us = Measure(true, rounds);
+        printf("%-10ld %12.1f %12.1f\n", RssMb(), fork_us, spawn_us);
+    }
+    return 0;
+}
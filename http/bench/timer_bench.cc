@@ -0,0 +1,79 @@
+// timer_bench：测量时间轮的开销
+//   arm：给 N 个连接设置定时器（每个连接各自的超时时间）
+//   rearm：给已经设置了定时器的连接重新设置（阶段切换）
+//   cancel：取消所有定时器
+//   advance：时间轮空转一个 tick，以及所有定时器在同一段时间内到期时每个到期定时器的开销
+// 用法：./timer_bench [连接数，默认 100000]
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include "../Timer.hpp"
+
+static double NsPerOp(std::chrono::steady_clock::time_point start, size_t ops)
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return (double)ns / ops;
+}
+
+int main(int argc, char *argv[])
+{
+    size_t n = argc > 1 ? atol(argv[1]) : 100000;
+    std::vector<TimerNode> nodes(n);
+    std::vector<uint64_t> timeouts(n);
+    std::mt19937 rng(1);
+    for (auto &t : timeouts)
+    {
+        t = 1000 + rng() % 60000; // 1 ~ 60 秒
+    }
+
+    TimerWheel wheel;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+        wheel.Add(&nodes[i], timeouts[i]);
+    }
+    printf("connections: %zu\n", n);
+    printf("arm:     %6.1f ns/op\n", NsPerOp(start, n));
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+        wheel.Add(&nodes[i], timeouts[n - 1 - i]);
+    }
+    printf("rearm:   %6.1f ns/op\n", NsPerOp(start, n));
+
+    uint64_t now = TimerWheel::NowMs();
+    start = std::chrono::steady_clock::now();
+    wheel.Advance(now + TIMER_TICK_MS, [](TimerNode *) {});
+    printf("tick:    %6.1f ns (no timer expires)\n", NsPerOp(start, 1));
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+        wheel.Del(&nodes[i]);
+    }
+    printf("cancel:  %6.1f ns/op\n", NsPerOp(start, n));
+
+    // 全部到期：推进 61 秒，每个定时器都在正确的 tick 上到期
+    for (size_t i = 0; i < n; i++)
+    {
+        wheel.Add(&nodes[i], timeouts[i]);
+    }
+    size_t expired = 0, late = 0;
+    uint64_t base = now / TIMER_TICK_MS * TIMER_TICK_MS;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t t = base + TIMER_TICK_MS; t <= base + 61000 + TIMER_TICK_MS; t += TIMER_TICK_MS)
+    {
+        wheel.Advance(t, [&](TimerNode *node) {
+            expired++;
+            if (node->expire != t / TIMER_TICK_MS)
+                late++;
+        });
+    }
+    printf("expire:  %6.1f ns/op (%zu expired, %zu on the wrong tick)\n", NsPerOp(start, n), expired, late);
+    return expired == n && late == 0 ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#!/usr/bin/python3
+# 常驻的 FastCGI 程序（只用标准库），和 test_cgi 做同样的计算，不用每个请求启动一次解释器
+# 用法：./fcgi_worker.py unix:/tmp/httpserver-fcgi.sock 或 ./fcgi_worker.py 127.0.0.1:9000
+# 服务器：./httpserver 8081 -f /test_cgi=unix:/tmp/httpserver-fcgi.sock
+# 支持多路复用：一个连接上的多个请求各用一个线程处理，写记录时加锁
+
+import os
+import socket
+import struct
+import sys
+import threading
+
+FCGI_BEGIN_REQUEST = 1
+FCGI_ABORT_REQUEST = 2
+FCGI_END_REQUEST = 3
+FCGI_PARAMS = 4
+FCGI_STDIN = 5
+FCGI_STDOUT = 6
+FCGI_GET_VALUES = 9
+FCGI_GET_VALUES_RESULT = 10
+FCGI_UNKNOWN_TYPE = 11
+FCGI_KEEP_CONN = 1
+MAX_REQS = 64
+
+
+def read_length(data, pos):
+    if data[pos] < 128:
+        return data[pos], pos + 1
+    return struct.unpack(">I", data[pos:pos + 4])[0] & 0x7fffffff, pos + 4
+
+
+def parse_params(data):
+    params = {}
+    pos = 0
+    while pos < len(data):
+        nlen, pos = read_length(data, pos)
+        vlen, pos = read_length(data, pos)
+        name = data[pos:pos + nlen].decode("latin-1")
+        params[name] = data[pos + nlen:pos + nlen + vlen].decode("latin-1")
+        pos += nlen + vlen
+    return params
+
+
+def encode_params(params):
+    out = b""
+    for name, value in params.items():
+        for s in (name, value):
+            n = len(s)
+            out += bytes([n]) if n < 128 else struct.pack(">I", n | 0x80000000)
+        out += name.encode() + value.encode()
+    return out
+
+
+def app(params, stdin):
+    if params.get("REQUEST_METHOD") == "POST":
+        query = stdin.decode("latin-1")
+    else:
+        query = params.get("QUERY_STRING", "")
+    values = dict(kv.split("=", 1) for kv in query.split("&") if "=" in kv)
+    x = int(values.get("a", "0") or 0)
+    y = int(values.get("b", "0") or 0)
+    body = "<html><head><meta charset=\"utf-8\"></head><body>"
+    body += "<h3> %d + %d = %d</h3>" % (x, y, x + y)
+    body += "<h3> %d - %d = %d</h3>" % (x, y, x - y)
+    body += "<h3> %d * %d = %d</h3>" % (x, y, x * y)
+    if y != 0:
+        body += "<h3> %d / %d = %d</h3>" % (x, y, int(x / y))
+    body += "<h3> pid %d</h3>" % os.getpid()
+    body += "</body></html>"
+    return "Content-Type: text/html; charset=utf-8\r\n\r\n" + body
+
+
+class Connection:
+    def __init__(self, sock):
+        self.sock = sock
+        self.lock = threading.Lock()
+        self.requests = {}  # id -> [keep_conn, params bytes, stdin bytes]
+
+    def send(self, type, id, content):
+        out = b""
+        for off in range(0, max(len(content), 1), 65535):
+            chunk = content[off:off + 65535]
+            pad = (8 - len(chunk) % 8) % 8
+            out += struct.pack(">BBHHBx", 1, type, id, len(chunk), pad) + chunk + b"\0" * pad
+        with self.lock:
+            self.sock.sendall(out)
+
+    def respond(self, id, params, stdin, keep_conn):
+        try:
+            out = app(params, stdin).encode()
+            status = 0
+        except Exception as e:
+            out = ("Status: 500 Internal Server Error\r\nContent-Type: text/plain\r\n\r\n%s" % e).encode()
+            status = 1
+        try:
+            self.send(FCGI_STDOUT, id, out)
+            self.send(FCGI_STDOUT, id, b"")
+            self.send(FCGI_END_REQUEST, id, struct.pack(">IB3x", status, 0))
+            if not keep_conn:
+                self.sock.shutdown(socket.SHUT_RDWR)
+        except OSError:
+            pass
+
+    def recv_exact(self, n):
+        data = b""
+        while len(data) < n:
+            chunk = self.sock.recv(n - len(data))
+            if not chunk:
+                raise EOFError
+            data += chunk
+        return data
+
+    def serve(self):
+        try:
+            while True:
+                version, type, id, clen, plen = struct.unpack(">BBHHBx", self.recv_exact(8))
+                content = self.recv_exact(clen + plen)[:clen]
+                if type == FCGI_GET_VALUES:
+                    answer = {"FCGI_MPXS_CONNS": "1", "FCGI_MAX_REQS": str(MAX_REQS), "FCGI_MAX_CONNS": str(MAX_REQS)}
+                    wanted = parse_params(content)
+                    self.send(FCGI_GET_VALUES_RESULT, 0, encode_params({k: v for k, v in answer.items() if k in wanted}))
+                elif type == FCGI_BEGIN_REQUEST:
+                    flags = content[2]
+                    self.requests[id] = [flags & FCGI_KEEP_CONN, b"", b""]
+                elif type == FCGI_ABORT_REQUEST:
+                    self.requests.pop(id, None)
+                elif type == FCGI_PARAMS and id in self.requests:
+                    self.requests[id][1] += content
+                elif type == FCGI_STDIN and id in self.requests:
+                    if content:
+                        self.requests[id][2] += content
+                    else:
+                        keep_conn, params, stdin = self.requests.pop(id)
+                        threading.Thread(target=self.respond, args=(id, parse_params(params), stdin, keep_conn), daemon=True).start()
+                elif id == 0:
+                    self.send(FCGI_UNKNOWN_TYPE, 0, struct.pack(">B7x", type))
+        except (EOFError, OSError):
+            pass
+        self.sock.close()
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("usage: %s unix:/path | host:port" % sys.argv[0])
+        sys.exit(1)
+    address = sys.argv[1]
+    if address.startswith("unix:") or address.startswith("/"):
+        path = address[5:] if address.startswith("unix:") else address
+        if os.path.exists(path):
+            os.unlink(path)
+        listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        listener.bind(path)
+    else:
+        host, port = address.rsplit(":", 1)
+        listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        listener.bind((host, int(port)))
+    listener.listen(128)
+    while True:
+        sock, _ = listener.accept()
+        threading.Thread(target=Connection(sock).serve, daemon=True).start()
+
+
+if __name__ == "__main__":
+    main()
@@ -1,23 +1,166 @@
 #include <iostream>
 #include <string>
 #include <memory>
+#include <cstring>
+#include <unistd.h>
 #include "HttpServer.hpp"
 
 static void Usage(std::string proc)
 {
-    std::cout << "Usage:\n\t" << proc << " port" << std::endl;;
+    std::cout << "Usage:\n\t" << proc << " port [-r reactor_num] [-k keepalive_timeout] [-n max_requests] [-b epoll|io_uring] [-c max_connections] [-q max_queued] [-d queue_target] [-w global|steal] [-t min_threads] [-m max_threads] [-Q cgi_max_queued] [-D cgi_queue_target] [-T cgi_min_threads] [-M cgi_max_threads] [-a none|cores|irq:name] [-f route=address]... [-F fastcgi_conns] [-o buffer|splice|stream] [-e cgi_timeout] [-s]" << std::endl;
+    std::cout << "\t-r reactor_num: 事件循环个数，0 表示每个 CPU 一个，默认 1" << std::endl;
+    std::cout << "\t-k keepalive_timeout: 长连接空闲超时（秒），0 表示不使用长连接，默认 " << KEEPALIVE_TIMEOUT << std::endl;
+    std::cout << "\t-n max_requests: 每个长连接最多处理的请求数，默认 " << MAX_KEEPALIVE_REQUESTS << std::endl;
+    std::cout << "\t-b backend: I/O 后端，epoll 或 io_uring（内核不支持时退回到 epoll），默认 epoll" << std::endl;
+    std::cout << "\t-c max_connections: 最多同时打开的连接数，超过时直接回复 503，0 表示不限制，默认 " << MAX_CONNECTIONS << std::endl;
+    std::cout << "\t-q max_queued: 线程池最多积压的请求数（向上取整到 2 的幂），超过时直接回复 503，0 表示 " << TASK_QUEUE_CAPACITY << "，默认 " << MAX_QUEUED_REQUESTS << std::endl;
+    std::cout << "\t-d queue_target: 请求在线程池队列中的目标等待时间（毫秒），持续超过时拒绝等待过久的请求，0 表示不限制，默认 " << QUEUE_TARGET_MS << std::endl;
+    std::cout << "\t-w pool_mode: 线程池的调度方式，global 为共享任务队列，steal 为每个线程一个队列并互相窃取，默认 global" << std::endl;
+    std::cout << "\t-t min_threads: 线程池的线程数下限，0 表示 CPU 个数，默认 0" << std::endl;
+    std::cout << "\t-m max_threads: 线程池的线程数上限，有任务排队并且线程阻塞在 CGI 上时在上下限之间增加线程，0 表示 CPU 个数的 " << THREADS_PER_CPU << " 倍，默认 0" << std::endl;
+    std::cout << "\t-q/-d/-t/-m 设置处理静态文件的线程池，-Q/-D/-T/-M 是 CGI 线程池的同一组参数，默认值相同" << std::endl;
+    std::cout << "\t-a affinity: 线程的放置，none 不绑定；cores 把 reactor 各绑定一个 CPU（在 NUMA 节点之间轮流），工作线程绑定到对应 reactor 所在的节点；"
+                 "irq:name 把 reactor 绑定到 /proc/interrupts 中名字包含 name 的网卡接收队列中断所在的 CPU，默认 none" << std::endl;
+    std::cout << "\t-f route=address: 把路径前缀（/app）或后缀（*.py）的请求交给 FastCGI 后端（unix:/path 或 host:port），可以重复；"
+                 "没有匹配的路径仍然每个请求启动一次 CGI 程序，连不上后端时本地有同名的可执行程序也退回到直接执行它；"
+                 "后端的输出收完整之后再发送（不受 -o 影响）：FastCGI 没有按请求的流量控制，多路复用的连接上边收边发给慢客户端会拖住同一连接上的其他请求，"
+                 "等待后端时 CGI 线程池的线程阻塞（按 -M 增加线程）" << std::endl;
+    std::cout << "\t-F fastcgi_conns: 每个 FastCGI 后端最多的连接数，默认 " << FCGI_MAX_CONNS << std::endl;
+    std::cout << "\t-o cgi_output: CGI 输出的发送方式，buffer 读完整个输出再按 Content-Length 发送；"
+                 "splice 子进程启动后就发送响应头，正文用 splice 从管道直接发送到套接字（不经过用户空间），发送完关闭连接；"
+                 "stream 子进程第一次输出时发送响应头，正文边读边发，HTTP/1.1 用分块编码（保持连接），HTTP/1.0 发送完关闭连接，默认 buffer；"
+                 "只对服务器自己启动的 CGI 程序生效，FastCGI 路由总是 buffer" << std::endl;
+    std::cout << "\t-e cgi_timeout: CGI 程序的执行超时（秒），从子进程启动开始计时，到期时杀掉它（连同它启动的进程）并关闭连接，0 表示不限制，默认 " << CGI_TIMEOUT << std::endl;
+    std::cout << "\t-s: 开放 " << STATUS_URI << "，回复服务器的计数器（队列长度、线程池规模、拒绝的请求数等）；"
+                 "它对所有客户端可见，只应在内网或有访问控制的监听地址上开启，默认关闭（这个路径和其他路径一样查找 wwwroot 下的文件）" << std::endl;
 }
 
 int main(int argc, char *argv[])
 {
-    if( argc != 2 ){
+    ServerConfig config;
+    int opt = 0;
+    while( (opt = getopt(argc, argv, "r:k:n:b:c:q:d:w:t:m:a:Q:D:T:M:f:F:o:e:s")) != -1 ){
+        switch(opt){
+            case 'r':
+                config.reactor_num = atoi(optarg);
+                break;
+            case 'k':
+                config.keepalive_timeout = atoi(optarg);
+                break;
+            case 'n':
+                config.max_requests = atoi(optarg);
+                break;
+            case 'b':
+                if( strcmp(optarg, "epoll") == 0 ){
+                    config.backend = BACKEND_EPOLL;
+                }
+                else if( strcmp(optarg, "io_uring") == 0 ){
+                    config.backend = BACKEND_URING;
+                }
+                else{
+                    Usage(argv[0]);
+                    exit(4);
+                }
+                break;
+            case 'c':
+                config.max_connections = atoi(optarg);
+                break;
+            case 'q':
+                config.max_queued = atoi(optarg);
+                break;
+            case 'd':
+                config.queue_target = atoi(optarg);
+                break;
+            case 'w':
+                if( strcmp(optarg, "global") == 0 ){
+                    config.pool_mode = POOL_GLOBAL;
+                }
+                else if( strcmp(optarg, "steal") == 0 ){
+                    config.pool_mode = POOL_STEAL;
+                }
+                else{
+                    Usage(argv[0]);
+                    exit(4);
+                }
+                break;
+            case 't':
+                config.min_threads = atoi(optarg);
+                break;
+            case 'm':
+                config.max_threads = atoi(optarg);
+                break;
+            case 'Q':
+                config.cgi_max_queued = atoi(optarg);
+                break;
+            case 'D':
+                config.cgi_queue_target = atoi(optarg);
+                break;
+            case 'T':
+                config.cgi_min_threads = atoi(optarg);
+                break;
+            case 'M':
+                config.cgi_max_threads = atoi(optarg);
+                break;
+            case 'a':
+                if( strcmp(optarg, "none") == 0 ){
+                    config.affinity = AFFINITY_NONE;
+                }
+                else if( strcmp(optarg, "cores") == 0 ){
+                    config.affinity = AFFINITY_CORES;
+                }
+                else if( strncmp(optarg, "irq:", 4) == 0 && optarg[4] != '\0' ){
+                    config.affinity = AFFINITY_IRQ;
+                    config.irq_name = optarg + 4;
+                }
+                else{
+                    Usage(argv[0]);
+                    exit(4);
+                }
+                break;
+            case 'f':
+                if( strchr(optarg, '=') == nullptr ){
+                    Usage(argv[0]);
+                    exit(4);
+                }
+                config.fastcgi.push_back(optarg);
+                break;
+            case 'F':
+                config.fastcgi_conns = atoi(optarg);
+                break;
+            case 'e':
+                config.cgi_timeout = atoi(optarg);
+                break;
+            case 'o':
+                if( strcmp(optarg, "buffer") == 0 ){
+                    config.cgi_output = CGI_OUTPUT_BUFFER;
+                }
+                else if( strcmp(optarg, "splice") == 0 ){
+                    config.cgi_output = CGI_OUTPUT_SPLICE;
+                }
+                else if( strcmp(optarg, "stream") == 0 ){
+                    config.cgi_output = CGI_OUTPUT_STREAM;
+                }
+                else{
+                    Usage(argv[0]);
+                    exit(4);
+                }
+                break;
+            case 's':
+                config.status_page = true;
+                break;
+            default:
+                Usage(argv[0]);
+                exit(4);
+        }
+    }
+    if( optind != argc - 1 ){
         Usage(argv[0]);
         exit(4);
     }
-    int port = atoi(argv[1]);
+    int port = atoi(argv[optind]);
 
     // 创建 httpserver 对象
-    std::shared_ptr<HttpServer> http_server(new HttpServer(port));
+    std::shared_ptr<HttpServer> http_server(new HttpServer(port, config));
 
     // 初始化
     http_server->InitServer();